@@ -0,0 +1,131 @@
+#include "affinity.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+
+// Where a CPU sits in the machine
+struct cpu_place {
+    int cpu;      // Logical CPU number
+    int package;  // physical_package_id
+    int core;     // Index of the core within its package (0, 1, ... in core_id order)
+    int sibling;  // Index of the CPU among the SMT siblings of its core
+};
+
+// Read one integer topology attribute of a CPU, fallback if the file is missing (e.g. no sysfs)
+static int read_topology(int cpu, const char *name, int fallback) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return fallback;
+    }
+    int value = fallback;
+    if (fscanf(file, "%d", &value) != 1) {
+        value = fallback;
+    }
+    fclose(file);
+    return value;
+}
+
+// Topology of every CPU in the calling thread's affinity mask
+static vector<cpu_place> read_places() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return {};
+    }
+    vector<cpu_place> places;
+    vector<int> core_ids;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            // Without topology files every CPU counts as its own core of package 0
+            places.push_back({cpu, read_topology(cpu, "physical_package_id", 0), 0, 0});
+            core_ids.push_back(read_topology(cpu, "core_id", cpu));
+        }
+    }
+    // core_id is only unique within a package and may have gaps: number the cores of each package 0, 1, ...
+    vector<pair<int, int>> cores;  // (package, core_id) of every core
+    for (size_t i = 0; i < places.size(); i++) {
+        cores.push_back({places[i].package, core_ids[i]});
+    }
+    sort(cores.begin(), cores.end());
+    cores.erase(unique(cores.begin(), cores.end()), cores.end());
+    for (size_t i = 0; i < places.size(); i++) {
+        auto core = lower_bound(cores.begin(), cores.end(), make_pair(places[i].package, core_ids[i]));
+        auto first = lower_bound(cores.begin(), cores.end(), make_pair(places[i].package, INT_MIN));
+        places[i].core = core - first;
+        for (size_t j = 0; j < i; j++) {
+            // CPUs are visited in ascending order, so the siblings before this one have lower numbers
+            places[i].sibling += places[j].package == places[i].package && core_ids[j] == core_ids[i];
+        }
+    }
+    return places;
+}
+
+static vector<int> cpus_of(const vector<cpu_place> &places) {
+    vector<int> cpus;
+    for (const cpu_place &place : places) {
+        cpus.push_back(place.cpu);
+    }
+    return cpus;
+}
+
+vector<int> affinity_compact() {
+    vector<cpu_place> places = read_places();
+    sort(places.begin(), places.end(), [](const cpu_place &a, const cpu_place &b) {
+        if (a.package != b.package) return a.package < b.package;
+        if (a.core != b.core) return a.core < b.core;
+        return a.sibling < b.sibling;
+    });
+    return cpus_of(places);
+}
+
+vector<int> affinity_scatter() {
+    vector<cpu_place> places = read_places();
+    sort(places.begin(), places.end(), [](const cpu_place &a, const cpu_place &b) {
+        if (a.sibling != b.sibling) return a.sibling < b.sibling;
+        if (a.core != b.core) return a.core < b.core;
+        return a.package < b.package;
+    });
+    return cpus_of(places);
+}
+
+vector<int> affinity_parse(const char *list) {
+    vector<int> cpus;
+    const char *pos = list;
+    while (*pos) {
+        char *end;
+        long first = strtol(pos, &end, 10);
+        if (end == pos || first < 0) {
+            return {};
+        }
+        long last = first;
+        pos = end;
+        if (*pos == '-') {
+            last = strtol(pos + 1, &end, 10);
+            if (end == pos + 1 || last < first) {
+                return {};
+            }
+            pos = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (*pos == ',') {
+            pos++;
+        } else if (*pos) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+bool affinity_pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
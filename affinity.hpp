@@ -0,0 +1,20 @@
+// Thread placement for the driver threads (--affinity).
+//
+// The CPU orders are built from the sysfs topology (/sys/devices/system/cpu/cpuN/topology) of the CPUs the
+// process may run on. Thread i runs on entry i of the order, wrapping around when there are more threads
+// than CPUs:
+//   - compact: SMT siblings of a core first, then the next core of the package, then the next package, so
+//     the threads share as many caches as possible
+//   - scatter: one core of every package first, then the next core of every package, SMT siblings last, so
+//     the threads get as many private caches (and as much memory bandwidth) as possible
+//   - list: the CPUs given on the command line, e.g. 0,2,4-7
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+vector<int> affinity_compact();               // Allowed CPUs in compact order
+vector<int> affinity_scatter();               // Allowed CPUs in scatter order
+vector<int> affinity_parse(const char *list); // CPUs of a list like 0,2,4-7 (empty if it does not parse)
+bool affinity_pin(int cpu);                   // Pin the calling thread to one CPU
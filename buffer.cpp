@@ -1,473 +1,2423 @@
-#include "buffer.hpp"
-#include <iostream>
-#include <random>
-#include <chrono>
-#include <thread>
-
-// Compare and Swap (CAS) helper function for atomic operations
-template <typename T>
-bool cas(atomic<T> &status, T expected, T desired, memory_order mem_order) {
-    T expected_ref = expected;
-    return status.compare_exchange_strong(expected_ref, desired, mem_order);
-}
-
-
-
-// Constructor for the stack
-stack::stack() {
-    top = nullptr; // Initialize the stack to be empty
-    lock.store(false);
-}
-
-// Push an element onto the stack
-void stack::push(int element) {
-    stack_node *temp = new stack_node(element, nullptr);
-    while(!cas(lock, false, true, ACQ_REL));
-    temp->next = top;  // Link the new node to the current top
-    top = temp;        // Update the top pointer to the new node
-    lock.store(false, REL);
-}
-
-// Pop an element from the stack and return its value
-bool stack::pop(int &element) {
-    while(!cas(lock, false, true, ACQ_REL));
-    stack_node *temp = top;
-    if(!temp) {
-        lock.store(false, REL);
-        return false;  // Return false if the stack is empty
-    }
-    element = temp->element;  // Get the value from the top node
-    top = top->next;  // Update the top pointer to the next node
-    delete temp;      // Free the memory of the popped node
-    lock.store(false, REL);
-    return true;
-}
-
-// Constructor for the queue
-queue::queue() {
-    head = nullptr;
-    tail = nullptr;
-    lock.store(false);
-}
-
-// Insert an element at the end of the queue
-void queue::insert(int element) {
-    queue_node *temp = new queue_node(element, nullptr);
-    while(!cas(lock, false, true, ACQ_REL));
-    if (!head) {
-        head = tail = temp;  // If the queue is empty, the new node becomes the head and tail
-    } else {
-        tail->next = temp;  // Add the new node to the end of the queue
-        tail = temp;        // Update the tail pointer to the new node
-    }
-    lock.store(false, REL);
-}
-
-// Remove an element from the front of the queue and return its value
-bool queue::remove(int &element) {
-    while(!cas(lock, false, true, ACQ_REL));
-    if (!head) {  // If the queue is empty
-        tail = nullptr;  // Reset the tail pointer
-        lock.store(false, REL);
-        return false;    // Return false
-    }
-    queue_node *temp = head;
-    element = temp->element;  // Get the value from the head node
-    head = head->next;        // Update the head pointer to the next node
-    delete temp;              // Free the memory of the removed node
-    lock.store(false, REL);
-    return true;
-}
-
-// Constructor for Treiber's stack (non-blocking stack)
-treiber_stack::treiber_stack() {
-    top.store(nullptr, RELAXED);  // Initialize the top pointer atomically to null
-}
-
-// Push an element onto the Treiber stack (non-blocking)
-void treiber_stack::push(int element) {
-    stack_node *temp = new stack_node(element, nullptr);
-    temp->next = top.load(ACQ);  // Set the next pointer to the current top
-    while (!cas(top, temp->next, temp, ACQ_REL)) {  // Attempt to update the top pointer atomically
-        temp->next = top.load(ACQ);  // Reload the top if CAS fails
-    }
-}
-
-// Pop an element from the Treiber stack (non-blocking)
-bool treiber_stack::pop(int &element) {
-    stack_node *temp = top.load(ACQ);  // Load the current top node atomically
-    if(!temp){
-        return false;
-    }
-    while (!cas(top, temp, temp->next, ACQ_REL)) {  // Attempt to pop the top node atomically
-        temp = top.load(ACQ);  // Reload the top if CAS fails
-        if(!temp){
-            return false;
-        }
-    }
-    element = temp->element;  // Get the value of the popped node
-    delete temp;  // Free the memory of the popped node
-    return true;
-}
-
-// Constructor for M&S queue (multi-threaded, lock-free queue)
-mns_queue::mns_queue() {
-    queue_node *dummy = new queue_node(0, nullptr);
-    head.store(dummy, RELAXED);;  // Create a dummy head node
-    tail.store(dummy, RELAXED);  // Initialize the tail pointer atomically to the dummy node
-}
-
-void mns_queue::insert(int element) {
-    queue_node *temp = new queue_node(element, nullptr);  // Create a new node
-    while (true) {
-        queue_node *last = tail.load(ACQ);               // Load the current tail atomically
-        queue_node *next = last->next;                  // Check the next pointer of the tail
-        
-        if (next == nullptr) {                          // If the tail's next is null, link the new node
-                last->next = temp;
-                // If successful, update the tail to point to the new node
-                cas(tail, last, temp, ACQ_REL);
-                //cout << "I am here 1: "<< element << endl;
-                return;
-        } else {                                        // Tail is already being updated; advance the tail
-            cas(tail, last, next, ACQ_REL);
-        }
-    }
-}
-
-bool mns_queue::remove(int &element) {
-    while (true) {
-        queue_node *temp = head.load(ACQ);  // Load the current head atomically
-        if (!temp || !temp->next) {        // If the queue is empty
-            return false;
-        }
-        queue_node *next_node = temp->next;  // Get the next node
-        if (cas(head, temp, next_node, ACQ_REL)) {  // Attempt to update the head atomically
-            element = next_node->element;    // Retrieve the value from the next node
-            //delete temp;                     // Free the old head node
-            //cout << "I am here 2" << endl;
-            return true;
-        }
-        // CAS failed, retry
-    }
-}
-
-
-void treiber_stack_elim::push(int element) {
-    stack_node *temp = new stack_node(element, nullptr);
-    temp->next = top.load(ACQ);  // Set the next pointer to the current top
-
-    while (true) {
-        if (cas(top, temp->next, temp, ACQ_REL)) {
-            // Stack push successful
-            break;
-        }
-
-        // Elimination logic: try to place the element in the elimination array
-        random_device rd;
-        static thread_local mt19937 gen(rd());
-        uniform_int_distribution<> distrib(0, eli_arr.size() - 1);
-        int index = distrib(gen);
-
-        // Attempt to reserve the slot for elimination
-        if (cas(eli_arr[index].status, (int)EMPTY, (int)PUSH, ACQ_REL)) {
-            eli_arr[index].element = element;  // Store the element
-            this_thread::sleep_for(chrono::nanoseconds(10));  // Allow time for a matching pop
-            if (cas(eli_arr[index].status, (int)POP, (int)EMPTY, ACQ_REL)) {
-                // Element was consumed, cleanup and exit
-                delete temp;
-                return;
-            } else {
-                // Elimination failed, retry stack push
-                eli_arr[index].status.store(EMPTY, REL);  // Reset the slot
-            }
-        }
-
-        // Update temp->next in case the stack top changed during elimination
-        temp->next = top.load(ACQ);
-    }
-}
-
-
-
-bool treiber_stack_elim::pop(int &element) {
-    stack_node* temp = top.load(ACQ);
-
-    while (true) {
-        if (temp == nullptr) {
-            // Stack is empty, check elimination array
-            random_device rd;    // Random number generator seed
-            static thread_local mt19937 gen(rd());
-            uniform_int_distribution<> distrib(0, eli_arr.size() - 1);
-            int index = distrib(gen);
-
-            // Attempt to match a PUSH operation in the elimination array
-            if (cas(eli_arr[index].status, (int)PUSH, (int)POP, ACQ_REL)) {
-                // Successfully matched a push; retrieve the element
-                element = eli_arr[index].element;
-                eli_arr[index].status.store(EMPTY, REL);  // Reset the slot
-                return true;
-            }
-            return false;  // No stack elements or elimination match
-        }
-
-        // Attempt to pop from the stack
-        if (cas(top, temp, temp->next, ACQ_REL)) {
-            element = temp->element;
-            delete temp;  // Free the memory
-            return true;
-        }
-
-        // Retry stack pop or switch to elimination logic
-        temp = top.load(ACQ);  // Reload the top pointer for retry
-    }
-}
-
-
-// Push an element onto the stack with elimination
-void stack_elim::push(int element) {
-    // Create a new stack node with the provided element
-    stack_node* temp = new stack_node(element, nullptr);
-
-    static thread_local mt19937 gen(std::random_device{}()); // Thread-local random generator
-    uniform_int_distribution<> distrib(0, eli_arr.size() - 1); // Uniform distribution for index
-
-    while (true) {
-        // Attempt to acquire the lock for the stack operation
-        if (cas(lock, false, true, ACQ_REL)) {
-            // Lock acquired, perform the stack push
-            temp->next = top.load(ACQ);  // Atomically read the current top of the stack
-            top.store(temp, REL);        // Update the top of the stack to point to the new node
-            lock.store(false, REL);      // Release the lock after successful push operation
-            return;
-        }
-
-        // Lock acquisition failed, attempt elimination
-        int index = distrib(gen); // Generate a random index for the elimination array
-
-        // Try placing the element into the elimination array
-        if (cas(eli_arr[index].status, (int)EMPTY, (int)PUSH, ACQ_REL)) {
-            eli_arr[index].element = element;  // Set the element in the chosen slot
-            std::this_thread::sleep_for(std::chrono::nanoseconds(10)); // Short delay to simulate work
-
-            // Check if the element was consumed by a corresponding pop operation
-            if (cas(eli_arr[index].status, (int)POP, (int)EMPTY, ACQ_REL)) {
-                delete temp; // Element successfully eliminated; clean up node
-                return;
-            }
-
-            // Reset the elimination slot if not consumed
-            eli_arr[index].status.store(EMPTY, REL);
-        }
-    }
-}
-
-
-// Pop an element from the stack (using both lock and elimination)
-bool stack_elim::pop(int &element) {
-    static thread_local mt19937 gen(std::random_device{}()); // Thread-local random generator
-    uniform_int_distribution<> distrib(0, eli_arr.size() - 1); // Uniform distribution for index
-
-    while (true) {
-        // Attempt to acquire the lock for the stack pop operation
-        if (cas(lock, false, true, ACQ_REL)) {
-            stack_node* temp = top.load(ACQ);  // Load the top element atomically
-            if (!temp) {
-                lock.store(false, REL);  // Release the lock if stack is empty
-                return false;  // Stack is empty, nothing to pop
-            }
-
-            // Retrieve the element and update the top pointer
-            element = temp->element;
-            top.store(temp->next, REL);  // Update the top to the next element
-            lock.store(false, REL);      // Release the lock after pop
-            delete temp;                 // Delete the node to free memory
-            return true;
-        }
-
-        // Lock acquisition failed, attempt elimination
-        int index = distrib(gen);  // Generate a random index for the elimination array
-
-        // Attempt to match with a push operation in the elimination array
-        if (cas(eli_arr[index].status, (int)EMPTY, (int)POP, ACQ_REL)) {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(2)); // Short delay to allow matching
-
-            // Check if an element was provided by a push operation
-            if (eli_arr[index].status.load(ACQ) == EMPTY) {
-                element = eli_arr[index].element; // Retrieve the matched element
-                return true;
-            }
-
-            // Reset the slot to EMPTY if no match occurred
-            eli_arr[index].status.store(EMPTY, REL);
-        }
-    }
-}
-
-
-void stack_flat::push(int element) {
-    stack_node* temp = new stack_node(element, nullptr);
-    static thread_local mt19937 gen(std::random_device{}()); // Thread-local random generator
-    uniform_int_distribution<> distrib(0, eli_arr.size() - 1);
-
-    while (true) {
-        // Attempt to acquire the lock for stack push operation
-        if (cas(lock, false, true, ACQ_REL)) {
-            // Lock acquired - process all entries in the elimination array
-            for (int i = 0; i < (int)eli_arr.size(); i++) {
-                // Process elimination array slots in a lock-holder exclusive manner
-                if (eli_arr[i].status.load(ACQ) == PUSH) {
-                    bool matched = false;
-                    // Attempt to match this PUSH with a POP in the array
-                    for (int j = i + 1; j < (int)eli_arr.size(); j++) {
-                        if (eli_arr[j].status.load(ACQ) == POP) {
-                            // Match found - resolve the PUSH-POP pair
-                            eli_arr[j].element = eli_arr[i].element;  // Transfer the element
-                            eli_arr[j].status.store(EMPTY, REL);      // Reset the POP slot
-                            eli_arr[i].status.store(EMPTY, REL);      // Reset the PUSH slot
-                            matched = true;
-                            break;
-                        }
-                    }
-                    // If no match found, push the element into the stack
-                    if (!matched) {
-                        stack_node* new_node = new stack_node(eli_arr[i].element, nullptr);
-                        new_node->next = top.load(ACQ);  // Point the new node to the current top
-                        top.store(new_node, REL);        // Update the top of the stack
-                        eli_arr[i].status.store(EMPTY, REL);  // Reset the slot after push
-                    }
-                }
-                else if (eli_arr[i].status.load(ACQ) == POP) {
-                    bool matched = false;
-                    // Attempt to match this POP with a PUSH in the array
-                    for (int j = i + 1; j < (int)eli_arr.size(); j++) {
-                        if (eli_arr[j].status.load(ACQ) == PUSH) {
-                            // Match found - resolve the POP-PUSH pair
-                            eli_arr[i].element = eli_arr[j].element;  // Transfer the element
-                            eli_arr[i].status.store(EMPTY, REL);      // Reset the POP slot
-                            eli_arr[j].status.store(EMPTY, REL);      // Reset the PUSH slot
-                            matched = true;
-                            break;
-                        }
-                    }
-                    // If no match found, pop from the stack
-                    if (!matched) {
-                        stack_node* stack_top = top.load(ACQ);
-                        if (stack_top) {
-                            eli_arr[i].element = stack_top->element;  // Assign top element to elimination slot
-                            top.store(stack_top->next, REL);  // Update top
-                            delete stack_top;  // Delete the old top node
-                        }
-                        eli_arr[i].status.store(EMPTY, REL);  // Reset the slot after pop
-                    }
-                }
-            }
-
-            // Proceed with the regular push operation
-            temp->next = top.load(ACQ);  // Atomically set the next pointer to the current top
-            top.store(temp, REL);        // Update the top of the stack
-
-            lock.store(false, REL);  // Release the lock
-            return;
-        }
-
-        // Elimination handling if the lock acquisition fails
-        int index = distrib(gen);  // Generate a random index
-        if (cas(eli_arr[index].status, (int)EMPTY, (int)PUSH, ACQ_REL)) {
-            eli_arr[index].element = element;
-            std::this_thread::sleep_for(std::chrono::nanoseconds(2));
-
-            // If the element was consumed, exit the loop
-            if (eli_arr[index].status.load(ACQ) == EMPTY) {
-                delete temp;  // Element was successfully eliminated
-                return;
-            }
-        }
-    }
-}
-
-
-bool stack_flat::pop(int &element) {
-    while (true) {
-        // Attempt to acquire the lock for stack pop operation
-        if (cas(lock, false, true, ACQ_REL)) {
-            stack_node* temp = top.load(ACQ);  // Load the top element atomically
-            if (!temp) {
-                lock.store(false, REL);  // Release the lock if stack is empty
-                return false;  // Stack is empty
-            }
-
-            element = temp->element;  // Retrieve the element
-            top.store(temp->next, REL);  // Update the top pointer
-
-            // Traverse the elimination array to handle events
-            for (int i = 0; i < (int)eli_arr.size(); i++) {
-                if (eli_arr[i].status.load(ACQ) == PUSH) {
-                    bool matched = false;
-                    for (int j = i + 1; j < (int)eli_arr.size(); j++) {
-                        // Try matching a PUSH with a POP
-                        if (eli_arr[j].status.load(ACQ) == POP) {
-                            eli_arr[j].element = eli_arr[i].element;  // Resolve the PUSH-POP pair
-                            eli_arr[j].status.store(EMPTY, REL);  // Mark the slot as empty
-                            eli_arr[i].status.store(EMPTY, REL);  // Mark the slot as empty
-                            matched = true;
-                            break; // Continue with the next PUSH slot
-                        }
-                    }
-                    // If no match found, push the element into the stack
-                    if (!matched) {
-                        stack_node* new_node = new stack_node(eli_arr[i].element, nullptr);
-                        new_node->next = top.load(ACQ);  // Point the new node to the current top
-                        top.store(new_node, REL);        // Update the top of the stack
-                        eli_arr[i].status.store(EMPTY, REL);  // Reset the slot
-                    }
-                } else if (eli_arr[i].status.load(ACQ) == POP) {
-                    bool matched = false;
-                    for (int j = i + 1; j < (int)eli_arr.size(); j++) {
-                        // Try matching a POP with a PUSH
-                        if (eli_arr[j].status.load(ACQ) == PUSH) {
-                            eli_arr[i].element = eli_arr[j].element;  // Resolve the POP-PUSH pair
-                            eli_arr[i].status.store(EMPTY, REL);  // Mark the slot as empty
-                            eli_arr[j].status.store(EMPTY, REL);  // Mark the slot as empty
-                            matched = true;
-                            break; // Continue with the next POP slot
-                        }
-                    }
-                    // If no match found, pop from the stack
-                    if (!matched) {
-                        stack_node* stack_top = top.load(ACQ);
-                        if (stack_top) {
-                            eli_arr[i].element = stack_top->element;  // Assign top element to the elimination slot
-                            top.store(stack_top->next, REL);  // Update top pointer
-                            delete stack_top;  // Delete the old top node
-                        }
-                        eli_arr[i].status.store(EMPTY, REL);  // Mark the slot as empty
-                    }
-                }
-            }
-
-            lock.store(false, REL);  // Release the lock
-            return true;  // Return true indicating a successful pop operation
-        }
-
-        // Attempt elimination if lock acquisition fails
-        random_device rd;    // Random number generator seed
-        mt19937 gen(rd());   // Mersenne Twister random number generator
-        uniform_int_distribution<> distrib(0, eli_arr.size() - 1);  // Uniform distribution for index
-        int index = distrib(gen);  // Generate a random index for the elimination array
-
-        // Try to eliminate the pop operation
-        if (cas(eli_arr[index].status, (int)EMPTY, (int)POP, ACQ_REL)) {
-            while (true) {
-                if (eli_arr[index].status.load(ACQ) == EMPTY) {
-                    // If the slot is empty, element has been successfully popped
-                    element = eli_arr[index].element;
-                    return true;
-                }
-            }
-        }
-    }
-}
-
-
-
+#include "buffer.hpp"
+#include <iostream>
+#include <thread>
+#include <functional>
+
+// Constructor for the stack
+template <typename T, typename Lock>
+stack<T, Lock>::stack() {
+    top = nullptr; // Initialize the stack to be empty
+}
+
+// Push an element onto the stack
+template <typename T, typename Lock>
+void stack<T, Lock>::push_node(stack_node<T> *temp) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    temp->next = top;  // Link the new node to the current top
+    top = temp;        // Update the top pointer to the new node
+    lock.unlock(qnode);
+    gate.notify();
+}
+
+// Pop an element from the stack and return its value
+template <typename T, typename Lock>
+bool stack<T, Lock>::pop(T &element) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    stack_node<T> *temp = top;
+    if(!temp) {
+        lock.unlock(qnode);
+        CONTENTION_COUNT(empty_pops);
+        return false;  // Return false if the stack is empty
+    }
+    element = move(temp->element);  // Get the value from the top node
+    top = top->next;  // Update the top pointer to the next node
+    delete temp;      // Free the memory of the popped node
+    lock.unlock(qnode);
+    return true;
+}
+
+// Link a private chain on top of the stack with one lock hold
+template <typename T, typename Lock>
+void stack<T, Lock>::push_chain(stack_node<T> *first, stack_node<T> *last) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    last->next = top;
+    top = first;
+    lock.unlock(qnode);
+    gate.notify();
+}
+
+// Pop up to max elements with one lock hold; the nodes are freed after the lock is released
+template <typename T, typename Lock>
+size_t stack<T, Lock>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    stack_node<T> *first = top;
+    stack_node<T> *last = first;
+    size_t count = first ? 1 : 0;
+    while (count && count < max && last->next) {
+        last = last->next;
+        count++;
+    }
+    if (count) {
+        top = last->next;  // Detach first..last
+    }
+    lock.unlock(qnode);
+
+    for (size_t i = 0; i < count; i++) {
+        stack_node<T> *next = first->next;
+        out[i] = move(first->element);
+        delete first;
+        first = next;
+    }
+    return count;
+}
+
+// Constructor for the queue
+template <typename T, typename Lock>
+queue<T, Lock>::queue() {
+    head = nullptr;
+    tail = nullptr;
+}
+
+// Insert an element at the end of the queue
+template <typename T, typename Lock>
+void queue<T, Lock>::insert_node(queue_node<T> *temp) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    if (!head) {
+        head = tail = temp;  // If the queue is empty, the new node becomes the head and tail
+    } else {
+        tail->next = temp;  // Add the new node to the end of the queue
+        tail = temp;        // Update the tail pointer to the new node
+    }
+    lock.unlock(qnode);
+    gate.notify();
+}
+
+// Remove an element from the front of the queue and return its value
+template <typename T, typename Lock>
+bool queue<T, Lock>::remove(T &element) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    if (!head) {  // If the queue is empty
+        tail = nullptr;  // Reset the tail pointer
+        lock.unlock(qnode);
+        CONTENTION_COUNT(empty_pops);
+        return false;    // Return false
+    }
+    queue_node<T> *temp = head;
+    element = move(temp->element);  // Get the value from the head node
+    head = head->next;        // Update the head pointer to the next node
+    delete temp;              // Free the memory of the removed node
+    lock.unlock(qnode);
+    return true;
+}
+
+// Link a private chain at the tail of the queue with one lock hold
+template <typename T, typename Lock>
+void queue<T, Lock>::insert_chain(queue_node<T> *first, queue_node<T> *last) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    if (!head) {
+        head = first;
+    } else {
+        tail->next = first;
+    }
+    tail = last;
+    lock.unlock(qnode);
+    gate.notify();
+}
+
+// Remove up to max elements with one lock hold; the nodes are freed after the lock is released
+template <typename T, typename Lock>
+size_t queue<T, Lock>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    queue_node<T> *first = head;
+    queue_node<T> *last = first;
+    size_t count = first ? 1 : 0;
+    while (count && count < max && last->next) {
+        last = last->next;
+        count++;
+    }
+    if (count) {
+        head = last->next;  // Detach first..last
+    }
+    if (!head) {
+        tail = nullptr;
+    }
+    lock.unlock(qnode);
+
+    for (size_t i = 0; i < count; i++) {
+        queue_node<T> *next = first->next;
+        out[i] = move(first->element);
+        delete first;
+        first = next;
+    }
+    return count;
+}
+
+// Link a private chain first..last on top of a Treiber stack with one successful CAS
+template <typename T>
+static void treiber_push_chain(atomic<stack_node<T> *> &top, stack_node<T> *first, stack_node<T> *last) {
+    last->next = top.load(ACQ);
+    while (!cas(top, last->next, first, ACQ_REL)) {
+        last->next = top.load(ACQ);
+    }
+}
+
+// Detach up to max nodes from the top of a Treiber stack with one successful CAS.
+// first stays protected in slot 0 so it cannot be freed and pushed again (no ABA on the CAS). The walk
+// publishes each node in slot 1 before dereferencing it and checks that top is still first: while it is,
+// nothing below first has been popped, so the published node has not been retired.
+template <typename T, typename Reclaimer>
+static size_t treiber_pop_bulk(atomic<stack_node<T> *> &top, T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    typename Reclaimer::guard guard;
+    while (true) {
+        stack_node<T> *first = guard.protect(0, top);
+        if (!first) {
+            return 0;
+        }
+        stack_node<T> *last = first;
+        size_t count = 1;
+        bool moved = false;
+        while (count < max) {
+            stack_node<T> *next = last->next;
+            if (!next) {
+                break;
+            }
+            guard.publish(1, next);
+            if (top.load(SEQCST) != first) {
+                moved = true;  // Someone popped first, the walk may be on retired nodes
+                break;
+            }
+            last = next;
+            count++;
+        }
+        if (moved || !cas(top, first, last->next, ACQ_REL)) {
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            stack_node<T> *next = first->next;
+            out[i] = move(first->element);
+            Reclaimer::retire(first, delete_node<stack_node<T>>);
+            first = next;
+        }
+        return count;
+    }
+}
+
+// Take every node of a Treiber stack with one exchange(nullptr).
+// The chain is private afterwards, but a concurrent pop may still be reading it, so nodes are retired.
+template <typename T, typename Reclaimer>
+static size_t treiber_drain(atomic<stack_node<T> *> &top, vector<T> &out) {
+    stack_node<T> *temp = top.exchange(nullptr, ACQ_REL);
+    size_t count = 0;
+    while (temp) {
+        stack_node<T> *next = temp->next;
+        out.push_back(move(temp->element));
+        Reclaimer::retire(temp, delete_node<stack_node<T>>);
+        temp = next;
+        count++;
+    }
+    return count;
+}
+
+// Constructor for Treiber's stack (non-blocking stack)
+template <typename T, typename Reclaimer>
+treiber_stack<T, Reclaimer>::treiber_stack() {
+    top.store(nullptr, RELAXED);  // Initialize the top pointer atomically to null
+}
+
+// Push an element onto the Treiber stack (non-blocking)
+template <typename T, typename Reclaimer>
+void treiber_stack<T, Reclaimer>::push_node(stack_node<T> *temp) {
+    temp->next = top.load(ACQ);  // Set the next pointer to the current top
+    while (!CONTENTION_CAS(PUSH, cas(top, temp->next, temp, ACQ_REL))) {  // Attempt to update the top pointer atomically
+        temp->next = top.load(ACQ);  // Reload the top if CAS fails
+    }
+    gate.notify();
+}
+
+// Pop an element from the Treiber stack (non-blocking)
+template <typename T, typename Reclaimer>
+bool treiber_stack<T, Reclaimer>::pop(T &element) {
+    typename Reclaimer::guard guard;  // Keeps temp alive while temp->next is read
+    stack_node<T> *temp = guard.protect(0, top);  // Load the current top node atomically
+    if(!temp){
+        CONTENTION_COUNT(empty_pops);
+        return false;
+    }
+    while (!CONTENTION_CAS(POP, cas(top, temp, temp->next, ACQ_REL))) {  // Attempt to pop the top node atomically
+        temp = guard.protect(0, top);  // Reload the top if CAS fails
+        if(!temp){
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+    }
+    element = move(temp->element);  // Get the value of the popped node
+    Reclaimer::retire(temp, delete_node<stack_node<T>>);  // Free the node once no other thread can reach it
+    return true;
+}
+
+template <typename T, typename Reclaimer>
+void treiber_stack<T, Reclaimer>::push_chain(stack_node<T> *first, stack_node<T> *last) {
+    treiber_push_chain(top, first, last);
+    gate.notify();
+}
+
+template <typename T, typename Reclaimer>
+size_t treiber_stack<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    return treiber_pop_bulk<T, Reclaimer>(top, out, max);
+}
+
+template <typename T, typename Reclaimer>
+size_t treiber_stack<T, Reclaimer>::drain(vector<T> &out) {
+    return treiber_drain<T, Reclaimer>(top, out);
+}
+
+// Push a node onto the tagged stack; the version makes a concurrent pop/push of the same node visible
+template <typename T>
+void treiber_stack_tagged<T>::push_node(tagged_node<T> *temp) {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_top = top.load();
+        temp->next.store(old_top.ptr, RELAXED);  // Link the new node to the current top
+        if (CONTENTION_CAS(PUSH, top.compare_exchange(old_top, temp))) {
+            gate.notify();
+            return;
+        }
+    }
+}
+
+// Pop from the tagged stack. old_top.ptr may be popped and pushed again by other threads after the
+// load; the node stays valid memory (it is only ever recycled) and the version change fails the CAS.
+template <typename T>
+bool treiber_stack_tagged<T>::pop(T &element) {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_top = top.load();
+        if (!old_top.ptr) {
+            CONTENTION_COUNT(empty_pops);
+            return false;  // Stack is empty
+        }
+        tagged_node<T> *next = old_top.ptr->next.load(RELAXED);
+        if (CONTENTION_CAS(POP, top.compare_exchange(old_top, next))) {
+            element = move(old_top.ptr->element);  // The node is ours now
+            recycle_node(old_top.ptr);
+            return true;
+        }
+    }
+}
+
+template <typename T>
+tagged_node<T> *treiber_stack_tagged<T>::acquire_node() {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_head = free_list.load();
+        if (!old_head.ptr) {
+            return new tagged_node<T>();  // Free list is empty, allocate from the pool
+        }
+        tagged_node<T> *next = old_head.ptr->next.load(RELAXED);
+        if (free_list.compare_exchange(old_head, next)) {
+            return old_head.ptr;
+        }
+    }
+}
+
+template <typename T>
+void treiber_stack_tagged<T>::recycle_node(tagged_node<T> *temp) {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_head = free_list.load();
+        temp->next.store(old_head.ptr, RELAXED);
+        if (free_list.compare_exchange(old_head, temp)) {
+            return;
+        }
+    }
+}
+
+// Link a private chain on top of the tagged stack with one successful CAS
+template <typename T>
+void treiber_stack_tagged<T>::push_chain(tagged_node<T> *first, tagged_node<T> *last) {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_top = top.load();
+        last->next.store(old_top.ptr, RELAXED);
+        if (top.compare_exchange(old_top, first)) {
+            gate.notify();
+            return;
+        }
+    }
+}
+
+// Detach up to max nodes with one CAS. The walk may read nodes that are popped and recycled concurrently
+// (they stay valid memory); the version on top makes the CAS fail in that case.
+template <typename T>
+size_t treiber_stack_tagged<T>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_top = top.load();
+        if (!old_top.ptr) {
+            return 0;
+        }
+        tagged_node<T> *last = old_top.ptr;
+        size_t count = 1;
+        tagged_node<T> *next = last->next.load(RELAXED);
+        while (count < max && next) {
+            last = next;
+            next = last->next.load(RELAXED);
+            count++;
+        }
+        if (top.compare_exchange(old_top, next)) {
+            tagged_node<T> *temp = old_top.ptr;
+            for (size_t i = 0; i < count; i++) {
+                out[i] = move(temp->element);
+                temp = temp->next.load(RELAXED);
+            }
+            recycle_chain(old_top.ptr, last);  // The detached nodes are still linked first..last
+            return count;
+        }
+    }
+}
+
+template <typename T>
+void treiber_stack_tagged<T>::recycle_chain(tagged_node<T> *first, tagged_node<T> *last) {
+    while (true) {
+        tagged_ptr<tagged_node<T>> old_head = free_list.load();
+        last->next.store(old_head.ptr, RELAXED);
+        if (free_list.compare_exchange(old_head, first)) {
+            return;
+        }
+    }
+}
+
+// Constructor for M&S queue (multi-threaded, lock-free queue)
+template <typename T, typename Reclaimer>
+mns_queue<T, Reclaimer>::mns_queue() {
+    mns_node<T> *dummy = new mns_node<T>();
+    head.store(dummy, RELAXED);;  // Create a dummy head node
+    tail.store(dummy, RELAXED);  // Initialize the tail pointer atomically to the dummy node
+}
+
+template <typename T, typename Reclaimer>
+void mns_queue<T, Reclaimer>::insert_node(mns_node<T> *temp) {
+    typename Reclaimer::guard guard;                  // Keeps the tail node alive while it is linked to
+    while (true) {
+        mns_node<T> *last = guard.protect(0, tail);     // Load the current tail atomically
+        mns_node<T> *next = last->next.load(ACQ);          // Check the next pointer of the tail
+        if (last != tail.load(ACQ)) {
+            continue;                                   // Tail moved, the snapshot is stale
+        }
+
+        if (next == nullptr) {                          // If the tail's next is null, link the new node
+            if (CONTENTION_CAS(PUSH, cas(last->next, next, temp, ACQ_REL))) {
+                // If successful, update the tail to point to the new node
+                cas(tail, last, temp, ACQ_REL);
+                gate.notify();
+                return;
+            }
+        } else {                                        // Tail is already being updated; advance the tail
+            cas(tail, last, next, ACQ_REL);
+        }
+    }
+}
+
+template <typename T, typename Reclaimer>
+bool mns_queue<T, Reclaimer>::remove(T &element) {
+    typename Reclaimer::guard guard;  // Keeps the head and its successor alive while they are read
+    while (true) {
+        mns_node<T> *temp = guard.protect(0, head);           // Load the current head atomically
+        mns_node<T> *last = tail.load(ACQ);
+        mns_node<T> *next_node = guard.protect(1, temp->next);  // Get the next node
+        if (temp != head.load(ACQ)) {
+            continue;                      // Head moved, next_node may already be retired
+        }
+        if (!next_node) {                  // If the queue is empty
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+        if (temp == last) {
+            cas(tail, last, next_node, ACQ_REL);  // Tail is lagging behind; help it before unlinking the head
+            continue;
+        }
+        if (CONTENTION_CAS(POP, cas(head, temp, next_node, ACQ_REL))) {  // Attempt to update the head atomically
+            element = move(next_node->element);  // Move the value out of the next node, which becomes the dummy
+            Reclaimer::retire(temp, delete_node<mns_node<T>>);  // Free the old dummy node once it is unreachable
+            return true;
+        }
+        // CAS failed, retry
+    }
+}
+
+// Link a private chain at the tail: one CAS on the last node's next, then swing tail to the chain's end.
+// Other threads that see the chain before tail moves help tail along it one node at a time.
+template <typename T, typename Reclaimer>
+void mns_queue<T, Reclaimer>::insert_chain(mns_node<T> *first, mns_node<T> *last) {
+    typename Reclaimer::guard guard;
+    while (true) {
+        mns_node<T> *end = guard.protect(0, tail);
+        mns_node<T> *next = end->next.load(ACQ);
+        if (end != tail.load(ACQ)) {
+            continue;
+        }
+        if (next == nullptr) {
+            if (cas(end->next, next, first, ACQ_REL)) {
+                cas(tail, end, last, ACQ_REL);
+                gate.notify();
+                return;
+            }
+        } else {
+            cas(tail, end, next, ACQ_REL);
+        }
+    }
+}
+
+// Move head past up to max nodes with one CAS. The dummy stays protected in slot 0; each node of the walk
+// is published in slot 1 and is known not to be retired as long as head is still the dummy. Tail is helped
+// past every node that is about to become unreachable, as the single remove does for the dummy.
+template <typename T, typename Reclaimer>
+size_t mns_queue<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    typename Reclaimer::guard guard;
+    while (true) {
+        mns_node<T> *first = guard.protect(0, head);
+        mns_node<T> *last = first;
+        size_t count = 0;
+        bool moved = false;
+        while (count < max) {
+            mns_node<T> *next = last->next.load(ACQ);
+            if (!next) {
+                break;
+            }
+            guard.publish(1, next);
+            if (head.load(SEQCST) != first) {
+                moved = true;
+                break;
+            }
+            while (tail.load(ACQ) == last) {
+                cas(tail, last, next, ACQ_REL);  // Tail is lagging behind; help it before unlinking last
+            }
+            last = next;
+            count++;
+        }
+        if (moved) {
+            continue;
+        }
+        if (count == 0) {
+            return 0;  // Empty
+        }
+        if (cas(head, first, last, ACQ_REL)) {
+            // last becomes the new dummy; first and the nodes before last are ours to retire
+            mns_node<T> *temp = first;
+            for (size_t i = 0; i < count; i++) {
+                mns_node<T> *next = temp->next.load(RELAXED);
+                out[i] = move(next->element);
+                Reclaimer::retire(temp, delete_node<mns_node<T>>);
+                temp = next;
+            }
+            return count;
+        }
+    }
+}
+
+
+// Constructor for the two-lock queue: head and tail start at the same dummy node
+template <typename T, typename Lock>
+twolock_queue<T, Lock>::twolock_queue() {
+    head = tail = new twolock_node<T>();
+}
+
+// The release store of next publishes the element to a dequeuer, which only holds the head lock
+template <typename T, typename Lock>
+void twolock_queue<T, Lock>::insert_node(twolock_node<T> *temp) {
+    typename Lock::node qnode;
+    tail_lock.lock(qnode);
+    tail->next.store(temp, REL);
+    tail = temp;
+    tail_lock.unlock(qnode);
+    gate.notify();
+}
+
+// The successor of the dummy becomes the new dummy once its element is moved out
+template <typename T, typename Lock>
+bool twolock_queue<T, Lock>::remove(T &element) {
+    typename Lock::node qnode;
+    head_lock.lock(qnode);
+    twolock_node<T> *dummy = head;
+    twolock_node<T> *next = dummy->next.load(ACQ);
+    if (!next) {
+        head_lock.unlock(qnode);
+        CONTENTION_COUNT(empty_pops);
+        return false;  // Empty
+    }
+    element = move(next->element);
+    head = next;
+    head_lock.unlock(qnode);
+    delete dummy;  // No enqueuer can reach the old dummy: tail already moved past it
+    return true;
+}
+
+template <typename T, typename Lock>
+void twolock_queue<T, Lock>::insert_chain(twolock_node<T> *first, twolock_node<T> *last) {
+    typename Lock::node qnode;
+    tail_lock.lock(qnode);
+    tail->next.store(first, REL);
+    tail = last;
+    tail_lock.unlock(qnode);
+    gate.notify();
+}
+
+// Remove up to max elements with one head lock hold; the old dummies are freed after the lock is released
+template <typename T, typename Lock>
+size_t twolock_queue<T, Lock>::pop_bulk(T *out, size_t max) {
+    typename Lock::node qnode;
+    head_lock.lock(qnode);
+    twolock_node<T> *first = head;
+    size_t count = 0;
+    while (count < max) {
+        twolock_node<T> *next = head->next.load(ACQ);
+        if (!next) {
+            break;
+        }
+        out[count++] = move(next->element);
+        head = next;
+    }
+    twolock_node<T> *stop = head;
+    head_lock.unlock(qnode);
+
+    while (first != stop) {
+        twolock_node<T> *next = first->next.load(RELAXED);
+        delete first;
+        first = next;
+    }
+    return count;
+}
+
+template <typename T>
+ring_queue<T>::ring_queue(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;  // Round up to a power of two so a position maps to a cell with a mask
+    }
+    cells = vector<ring_cell<T>>(size);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        cells[i].sequence.store(i, RELAXED);  // Cell i is free for the enqueuer of position i
+    }
+}
+
+template <typename T>
+ring_cell<T> *ring_queue<T>::claim_push(size_t &pos) {
+    pos = enqueue_pos.load(RELAXED);
+    while (true) {
+        ring_cell<T> *cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(ACQ);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // Cell is free for this lap, claim the position (pos is reloaded on failure)
+            if (CONTENTION_CAS(PUSH, enqueue_pos.compare_exchange_weak(pos, pos + 1, RELAXED))) {
+                return cell;
+            }
+        } else if (diff < 0) {
+            return nullptr;  // Cell still holds the element from the previous lap: full
+        } else {
+            pos = enqueue_pos.load(RELAXED);  // Another enqueuer took this position
+        }
+    }
+}
+
+template <typename T>
+bool ring_queue<T>::try_pop(T &element) {
+    size_t pos = dequeue_pos.load(RELAXED);
+    ring_cell<T> *cell;
+    while (true) {
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(ACQ);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            // Cell is full for this lap, claim the position (pos is reloaded on failure)
+            if (CONTENTION_CAS(POP, dequeue_pos.compare_exchange_weak(pos, pos + 1, RELAXED))) {
+                break;
+            }
+        } else if (diff < 0) {
+            CONTENTION_COUNT(empty_pops);
+            return false;  // Nothing enqueued at this position yet: empty
+        } else {
+            pos = dequeue_pos.load(RELAXED);  // Another dequeuer took this position
+        }
+    }
+    element = move(cell->element);
+    cell->sequence.store(pos + mask + 1, REL);  // Free the cell for the enqueuer of the next lap
+    return true;
+}
+
+// Claim the longest run (up to max) of cells that are free for this lap, starting at the enqueue position
+template <typename T>
+size_t ring_queue<T>::claim_push_bulk(size_t &pos, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    pos = enqueue_pos.load(RELAXED);
+    while (true) {
+        size_t count = 0;
+        while (count < max && cells[(pos + count) & mask].sequence.load(ACQ) == pos + count) {
+            count++;
+        }
+        if (count == 0) {
+            intptr_t diff = (intptr_t)cells[pos & mask].sequence.load(ACQ) - (intptr_t)pos;
+            if (diff < 0) {
+                return 0;  // Full
+            }
+            pos = enqueue_pos.load(RELAXED);  // Another enqueuer took this position
+            continue;
+        }
+        if (enqueue_pos.compare_exchange_weak(pos, pos + count, RELAXED)) {
+            return count;
+        }
+    }
+}
+
+// Claim the longest run (up to max) of full cells starting at the dequeue position and move them out
+template <typename T>
+size_t ring_queue<T>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    size_t pos = dequeue_pos.load(RELAXED);
+    size_t count;
+    while (true) {
+        count = 0;
+        while (count < max && cells[(pos + count) & mask].sequence.load(ACQ) == pos + count + 1) {
+            count++;
+        }
+        if (count == 0) {
+            intptr_t diff = (intptr_t)cells[pos & mask].sequence.load(ACQ) - (intptr_t)(pos + 1);
+            if (diff < 0) {
+                return 0;  // Empty
+            }
+            pos = dequeue_pos.load(RELAXED);  // Another dequeuer took this position
+            continue;
+        }
+        if (dequeue_pos.compare_exchange_weak(pos, pos + count, RELAXED)) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        ring_cell<T> &cell = cells[(pos + i) & mask];
+        out[i] = move(cell.element);
+        cell.sequence.store(pos + i + mask + 1, REL);
+    }
+    return count;
+}
+
+template <typename T>
+spsc_queue<T>::spsc_queue(size_t capacity) : head(0), cached_tail(0), tail(0), cached_head(0) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;  // Round up to a power of two so a position maps to a cell with a mask
+    }
+    cells.resize(size);
+    mask = size - 1;
+}
+
+template <typename T>
+bool spsc_queue<T>::try_pop(T &element) {
+    size_t pos = head.load(RELAXED);
+    if (pos == cached_tail) {
+        cached_tail = tail.load(ACQ);  // Looks empty, refresh the producer's index
+        if (pos == cached_tail) {
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+    }
+    element = move(cells[pos & mask]);
+    head.store(pos + 1, REL);  // Hand the cell back to the producer
+    return true;
+}
+
+template <typename T>
+size_t spsc_queue<T>::pop_bulk(T *out, size_t max) {
+    size_t pos = head.load(RELAXED);
+    if (cached_tail - pos < max) {
+        cached_tail = tail.load(ACQ);  // Not enough cached, refresh the producer's index
+    }
+    size_t count = min(max, cached_tail - pos);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = move(cells[(pos + i) & mask]);
+    }
+    head.store(pos + count, REL);  // Hand the whole batch of cells back to the producer
+    return count;
+}
+
+template <typename T, typename Reclaimer>
+faa_queue<T, Reclaimer>::faa_queue() {
+    faa_segment<T> *first = new faa_segment<T>();
+    head.store(first, RELAXED);
+    tail.store(first, RELAXED);
+}
+
+template <typename T, typename Reclaimer>
+void faa_queue<T, Reclaimer>::insert_element(T &element) {
+    typename Reclaimer::guard guard;  // Keeps the tail segment alive while its cells are written
+    while (true) {
+        faa_segment<T> *last = guard.protect(0, tail);
+        unsigned idx = last->enq_idx.fetch_add(1, ACQ_REL);  // Claim a cell
+        if (idx < FAA_SEGMENT_SIZE) {
+            faa_cell<T> &cell = last->cells[idx];
+            cell.element = move(element);
+            if (CONTENTION_CAS(PUSH, cas(cell.state, (int)CELL_EMPTY, (int)CELL_FULL, ACQ_REL))) {
+                gate.notify();
+                return;
+            }
+            element = move(cell.element);  // A dequeuer gave up on this cell, take the element back and retry
+            continue;
+        }
+
+        // Segment exhausted: link a new one holding the element, or help the enqueuer that already did
+        if (last != tail.load(ACQ)) {
+            continue;
+        }
+        faa_segment<T> *next = last->next.load(ACQ);
+        if (next) {
+            cas(tail, last, next, ACQ_REL);
+            continue;
+        }
+        faa_segment<T> *temp = new faa_segment<T>();
+        temp->cells[0].element = move(element);
+        temp->cells[0].state.store(CELL_FULL, RELAXED);
+        temp->enq_idx.store(1, RELAXED);
+        if (cas(last->next, (faa_segment<T> *)nullptr, temp, ACQ_REL)) {
+            cas(tail, last, temp, ACQ_REL);
+            gate.notify();
+            return;
+        }
+        element = move(temp->cells[0].element);  // Lost the race to link, retry on the winner's segment
+        delete temp;
+    }
+}
+
+template <typename T, typename Reclaimer>
+bool faa_queue<T, Reclaimer>::remove(T &element) {
+    typename Reclaimer::guard guard;  // Keeps the head segment alive while its cells are read
+    while (true) {
+        faa_segment<T> *first = guard.protect(0, head);
+        // Do not burn cells (and make enqueuers retry) when the queue is visibly empty
+        if (first->deq_idx.load(ACQ) >= first->enq_idx.load(ACQ) && first->next.load(ACQ) == nullptr) {
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+        unsigned idx = first->deq_idx.fetch_add(1, ACQ_REL);  // Claim a cell
+        if (idx < FAA_SEGMENT_SIZE) {
+            faa_cell<T> &cell = first->cells[idx];
+            if (CONTENTION_CAS(POP, cell.state.exchange(CELL_TAKEN, ACQ_REL) == CELL_FULL)) {
+                element = move(cell.element);
+                return true;
+            }
+            continue;  // The enqueuer of this cell has not arrived yet; it will retry elsewhere
+        }
+
+        // Segment drained: move head to the next segment and retire this one
+        faa_segment<T> *next = first->next.load(ACQ);
+        if (!next) {
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+        if (first == tail.load(ACQ)) {
+            cas(tail, first, next, ACQ_REL);  // Tail is lagging behind; help it before unlinking the head
+        }
+        if (cas(head, first, next, ACQ_REL)) {
+            Reclaimer::retire(first, delete_node<faa_segment<T>>);
+        }
+    }
+}
+
+// Claim count cells of the tail segment with one fetch_add. Elements that do not fit in the segment,
+// or whose cell was given up by an overtaking dequeuer, go through insert_element one by one.
+template <typename T, typename Reclaimer>
+void faa_queue<T, Reclaimer>::insert_bulk(T *elements, size_t count) {
+    size_t retry = count;  // Index of the first element that still has to be inserted one by one
+    vector<size_t> lost;   // Elements whose cell was taken before they were written
+    {
+        typename Reclaimer::guard guard;
+        faa_segment<T> *last = guard.protect(0, tail);
+        unsigned idx = last->enq_idx.fetch_add(count, ACQ_REL);
+        for (size_t i = 0; i < count; i++) {
+            if (idx + i >= FAA_SEGMENT_SIZE) {
+                retry = i;
+                break;
+            }
+            faa_cell<T> &cell = last->cells[idx + i];
+            cell.element = move(elements[i]);
+            if (!cas(cell.state, (int)CELL_EMPTY, (int)CELL_FULL, ACQ_REL)) {
+                elements[i] = move(cell.element);
+                lost.push_back(i);
+            }
+        }
+    }
+    gate.notify();  // The cells claimed above (the stragglers below notify on their own)
+    for (size_t i : lost) {
+        insert_element(elements[i]);
+    }
+    for (size_t i = retry; i < count; i++) {
+        insert_element(elements[i]);
+    }
+}
+
+// Claim up to max cells of the head segment with one CAS on deq_idx, never past enq_idx as read in the
+// same attempt, so a bulk dequeue does not overtake the enqueuers (a plain fetch_add would let two bulk
+// dequeuers both claim past it). Falls back to remove when the segment is drained.
+template <typename T, typename Reclaimer>
+size_t faa_queue<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    size_t count = 0;
+    {
+        typename Reclaimer::guard guard;
+        faa_segment<T> *first = guard.protect(0, head);
+        unsigned deq = first->deq_idx.load(ACQ);
+        unsigned want = 0;
+        while (true) {
+            unsigned enq = min(first->enq_idx.load(ACQ), (unsigned)FAA_SEGMENT_SIZE);
+            want = deq < enq ? min((unsigned)max, enq - deq) : 0;
+            if (want == 0 || first->deq_idx.compare_exchange_weak(deq, deq + want, ACQ_REL, ACQ)) {
+                break;  // Nothing left below enq_idx, or cells [deq, deq + want) are ours
+            }
+        }
+        for (unsigned i = 0; i < want; i++) {
+            faa_cell<T> &cell = first->cells[deq + i];
+            if (cell.state.exchange(CELL_TAKEN, ACQ_REL) == CELL_FULL) {
+                out[count++] = move(cell.element);
+            }
+        }
+    }
+    if (count == 0 && remove(out[0])) {
+        count = 1;  // Head segment drained (or raced), let remove move on to the next one
+    }
+    return count;
+}
+
+// Adaptive elimination (after Hendler, Shavit, Yerushalmi 2004). Each thread keeps its own view of how
+// many slots are worth using (range) and how long an offer should wait (spin, in pause iterations):
+//   - an offer taken by a pop: elimination pays off, wait longer next time
+//   - an offer nobody took, or a pop that found no offer: too few partners for the range, shrink it and
+//     wait less
+//   - a slot already in use by another pair: too many partners for the range, grow it
+struct elim_thread_state {
+    unsigned range = 1;              // Slots [0, range) of the array are in use
+    unsigned spin = ELIM_SPIN_MIN;   // Pause iterations an offer waits for a partner
+    uint32_t seed = 0;               // xorshift state for the slot choice
+    elim_stats local = {0, 0, 0};    // Counters not yet added to the totals
+
+    ~elim_thread_state();
+};
+
+static atomic<unsigned long long> total_elim_attempts(0);
+static atomic<unsigned long long> total_elim_hits(0);
+static atomic<unsigned long long> total_elim_young(0);
+static thread_local elim_thread_state elim_local;
+
+elim_thread_state::~elim_thread_state() {
+    total_elim_attempts.fetch_add(local.attempts, RELAXED);
+    total_elim_hits.fetch_add(local.hits, RELAXED);
+    total_elim_young.fetch_add(local.young, RELAXED);
+}
+
+elim_stats elim_get_stats() {
+    return {total_elim_attempts.load(RELAXED) + elim_local.local.attempts,
+            total_elim_hits.load(RELAXED) + elim_local.local.hits,
+            total_elim_young.load(RELAXED) + elim_local.local.young};
+}
+
+#ifdef CONTENTION_STATS
+static atomic<bool> contention_lock(false);  // Serializes the merges of exiting threads
+static contention_stats contention_totals = {};
+thread_local contention_thread_state contention_local;
+
+contention_thread_state::~contention_thread_state() {
+    while (!cas(contention_lock, false, true, ACQ_REL)) {
+        cpu_relax();
+    }
+    for (int op = 0; op < CONTENTION_OPS; op++) {
+        contention_totals.cas_attempts[op] += local.cas_attempts[op];
+        contention_totals.cas_failures[op] += local.cas_failures[op];
+    }
+    contention_totals.lock_acquires += local.lock_acquires;
+    contention_totals.lock_spins += local.lock_spins;
+    for (int i = 0; i < ELIM_MAX_WIDTH; i++) {
+        contention_totals.elim_attempts[i] += local.elim_attempts[i];
+        contention_totals.elim_hits[i] += local.elim_hits[i];
+        contention_totals.elim_timeouts[i] += local.elim_timeouts[i];
+    }
+    contention_totals.combiner_sessions += local.combiner_sessions;
+    contention_totals.combiner_passes += local.combiner_passes;
+    contention_totals.combined_ops += local.combined_ops;
+    contention_totals.max_batch = max(contention_totals.max_batch, local.max_batch);
+    contention_totals.empty_pops += local.empty_pops;
+    contention_lock.store(false, REL);
+}
+
+// Totals of the exited threads; the threads of a run have all been joined when main reads them
+contention_stats contention_get_stats() {
+    while (!cas(contention_lock, false, true, ACQ_REL)) {
+        cpu_relax();
+    }
+    contention_stats totals = contention_totals;
+    contention_lock.store(false, REL);
+    return totals;
+}
+#endif
+
+// Pick a slot in the calling thread's active range
+static unsigned elim_pick(elim_thread_state &state, size_t width) {
+    if (state.seed == 0) {
+        state.seed = (uint32_t)hash<thread::id>()(this_thread::get_id()) | 1;
+    }
+    state.seed ^= state.seed << 13;
+    state.seed ^= state.seed >> 17;
+    state.seed ^= state.seed << 5;
+    if (state.range > width) {
+        state.range = width;
+    }
+    return state.seed % state.range;
+}
+
+static void elim_hit(elim_thread_state &state) {
+    state.local.hits++;
+    state.spin = min(state.spin * 2, (unsigned)ELIM_SPIN_MAX);
+}
+
+static void elim_miss(elim_thread_state &state) {
+    if (state.range > 1) {
+        state.range--;
+    }
+    state.spin = max(state.spin / 2, (unsigned)ELIM_SPIN_MIN);
+}
+
+static void elim_collision(elim_thread_state &state, size_t width) {
+    state.range = min(state.range * 2, (unsigned)width);
+}
+
+// Offer an element to a concurrent pop through a slot of the array.
+// The slot is claimed as BUSY with a new tag while the element is moved in, then published as PUSH. A pop
+// that takes it switches the slot to POP, moves the element out and resets it to EMPTY. The pusher spins
+// (no syscall) for its current window; if nobody took the offer it withdraws it (PUSH -> BUSY, same tag),
+// moves the element back and releases the slot. Returns true if the element was handed to a pop.
+template <typename T>
+static bool eliminate_push(vector<elimination_array<T>> &eli_arr, T &element) {
+    elim_thread_state &state = elim_local;
+    state.local.attempts++;
+    unsigned index = elim_pick(state, eli_arr.size());
+    elimination_array<T> &slot = eli_arr[index];
+    CONTENTION_SLOT(elim_attempts, index);
+    unsigned long long idle = slot.state.load(ACQ);
+    unsigned long long tag = (idle & ~ELIM_STATUS_MASK) + ELIM_TAG_ONE;  // Tag of this claim
+    if ((idle & ELIM_STATUS_MASK) != EMPTY || !cas(slot.state, idle, tag | BUSY, ACQ_REL)) {
+        elim_collision(state, eli_arr.size());  // Slot in use by another pair
+        return false;
+    }
+    slot.element = move(element);        // Store the element
+    unsigned long long offer = tag | PUSH;
+    slot.state.store(offer, REL);        // Publish the offer
+    for (unsigned i = 0; i < state.spin && slot.state.load(ACQ) == offer; i++) {
+        cpu_relax();                     // Allow time for a matching pop
+    }
+    if (cas(slot.state, offer, tag | BUSY, ACQ_REL)) {
+        element = move(slot.element);    // Not taken, withdraw the offer
+        slot.state.store(tag | EMPTY, REL);
+        CONTENTION_SLOT(elim_timeouts, index);
+        elim_miss(state);
+        return false;
+    }
+    CONTENTION_SLOT(elim_hits, index);
+    elim_hit(state);
+    return true;  // A pop moved the element out, it resets the slot
+}
+
+// Take an element offered by a concurrent push from a slot of the array; returns true on a match
+template <typename T>
+static bool eliminate_pop(vector<elimination_array<T>> &eli_arr, T &element) {
+    elim_thread_state &state = elim_local;
+    state.local.attempts++;
+    unsigned index = elim_pick(state, eli_arr.size());
+    elimination_array<T> &slot = eli_arr[index];
+    CONTENTION_SLOT(elim_attempts, index);
+    unsigned long long offer = slot.state.load(ACQ);
+    unsigned long long status = offer & ELIM_STATUS_MASK;
+    unsigned long long tag = offer & ~ELIM_STATUS_MASK;
+    if (status != PUSH || !cas(slot.state, offer, tag | POP, ACQ_REL)) {
+        if (status == PUSH || status == POP) {
+            elim_collision(state, eli_arr.size());  // Another pop got there first
+        } else {
+            elim_miss(state);                       // No offer in this slot
+        }
+        return false;
+    }
+    element = move(slot.element);  // Successfully matched a push; retrieve the element
+    slot.state.store(tag | EMPTY, REL); // Reset the slot, keeping the tag
+    CONTENTION_SLOT(elim_hits, index);
+    elim_hit(state);
+    return true;
+}
+
+
+template <typename T, typename Reclaimer>
+void treiber_stack_elim<T, Reclaimer>::push_node(stack_node<T> *temp) {
+    temp->next = top.load(ACQ);  // Set the next pointer to the current top
+
+    while (true) {
+        if (CONTENTION_CAS(PUSH, cas(top, temp->next, temp, ACQ_REL))) {
+            // Stack push successful
+            gate.notify();
+            break;
+        }
+
+        // CAS failed under contention: try to hand the element to a pop through the elimination array
+        if (eliminate_push(eli_arr, temp->element)) {
+            // Element was consumed, cleanup and exit
+            delete temp;
+            return;
+        }
+
+        // Update temp->next in case the stack top changed during elimination
+        temp->next = top.load(ACQ);
+    }
+}
+
+
+
+template <typename T, typename Reclaimer>
+bool treiber_stack_elim<T, Reclaimer>::pop(T &element) {
+    typename Reclaimer::guard guard;  // Keeps temp alive while temp->next is read
+    stack_node<T>* temp = guard.protect(0, top);
+
+    while (true) {
+        if (temp == nullptr) {
+            // Stack is empty, a concurrent push may still be offering in the elimination array
+            if (eliminate_pop(eli_arr, element)) {
+                return true;
+            }
+            CONTENTION_COUNT(empty_pops);
+            return false;  // No stack elements and no elimination match
+        }
+
+        // Attempt to pop from the stack
+        if (CONTENTION_CAS(POP, cas(top, temp, temp->next, ACQ_REL))) {
+            element = move(temp->element);
+            Reclaimer::retire(temp, delete_node<stack_node<T>>);  // Free the node once it is unreachable
+            return true;
+        }
+
+        // CAS failed under contention: try to meet a push in the elimination array before retrying
+        if (eliminate_pop(eli_arr, element)) {
+            return true;
+        }
+        temp = guard.protect(0, top);  // Reload the top pointer for retry
+    }
+}
+
+// Bulk operations go straight to the stack: a batch is not handed to a single waiting pop
+template <typename T, typename Reclaimer>
+void treiber_stack_elim<T, Reclaimer>::push_chain(stack_node<T> *first, stack_node<T> *last) {
+    treiber_push_chain(top, first, last);
+    gate.notify();
+}
+
+template <typename T, typename Reclaimer>
+size_t treiber_stack_elim<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    return treiber_pop_bulk<T, Reclaimer>(top, out, max);
+}
+
+template <typename T, typename Reclaimer>
+size_t treiber_stack_elim<T, Reclaimer>::drain(vector<T> &out) {
+    return treiber_drain<T, Reclaimer>(top, out);
+}
+
+
+// Push an element onto the stack with elimination
+template <typename T, typename Lock>
+void stack_elim<T, Lock>::push_node(stack_node<T> *temp) {
+    typename Lock::node qnode;
+    while (true) {
+        // Attempt to acquire the lock for the stack operation without queueing behind other threads
+        if (lock.try_lock(qnode)) {
+            // Lock acquired, perform the stack push
+            temp->next = top.load(ACQ);  // Atomically read the current top of the stack
+            top.store(temp, REL);        // Update the top of the stack to point to the new node
+            lock.unlock(qnode);          // Release the lock after successful push operation
+            gate.notify();
+            return;
+        }
+
+        // Lock acquisition failed: try handing the element to a pop waiting on the lock
+        if (eliminate_push(eli_arr, temp->element)) {
+            delete temp; // Element successfully eliminated; clean up node
+            return;
+        }
+    }
+}
+
+
+// Pop an element from the stack (using both lock and elimination)
+template <typename T, typename Lock>
+bool stack_elim<T, Lock>::pop(T &element) {
+    typename Lock::node qnode;
+    while (true) {
+        // Attempt to acquire the lock for the stack pop operation without queueing behind other threads
+        if (lock.try_lock(qnode)) {
+            stack_node<T>* temp = top.load(ACQ);  // Load the top element atomically
+            if (!temp) {
+                lock.unlock(qnode);  // Release the lock if stack is empty
+                CONTENTION_COUNT(empty_pops);
+                return false;  // Stack is empty, nothing to pop
+            }
+
+            // Retrieve the element and update the top pointer
+            element = move(temp->element);
+            top.store(temp->next, REL);  // Update the top to the next element
+            lock.unlock(qnode);          // Release the lock after pop
+            delete temp;                 // Delete the node to free memory
+            return true;
+        }
+
+        // Lock acquisition failed: attempt to match with a push operation in the elimination array
+        if (eliminate_pop(eli_arr, element)) {
+            return true;
+        }
+    }
+}
+
+// Bulk operations wait for the lock instead of eliminating
+template <typename T, typename Lock>
+void stack_elim<T, Lock>::push_chain(stack_node<T> *first, stack_node<T> *last) {
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    last->next = top.load(ACQ);
+    top.store(first, REL);
+    lock.unlock(qnode);
+    gate.notify();
+}
+
+template <typename T, typename Lock>
+size_t stack_elim<T, Lock>::pop_bulk(T *out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    typename Lock::node qnode;
+    lock.lock(qnode);
+    stack_node<T> *first = top.load(ACQ);
+    stack_node<T> *last = first;
+    size_t count = first ? 1 : 0;
+    while (count && count < max && last->next) {
+        last = last->next;
+        count++;
+    }
+    if (count) {
+        top.store(last->next, REL);
+    }
+    lock.unlock(qnode);
+
+    for (size_t i = 0; i < count; i++) {
+        stack_node<T> *next = first->next;
+        out[i] = move(first->element);
+        delete first;
+        first = next;
+    }
+    return count;
+}
+
+// Offer an element to a concurrent dequeue, tagged with the seq of the tail the enqueuer saw.
+// Same protocol as eliminate_push, on a state word that also carries the seq.
+template <typename T>
+static bool eliminate_enqueue(vector<queue_elim_slot<T>> &eli_arr, T &element, unsigned long long seq) {
+    elim_thread_state &state = elim_local;
+    state.local.attempts++;
+    unsigned index = elim_pick(state, eli_arr.size());
+    queue_elim_slot<T> &slot = eli_arr[index];
+    CONTENTION_SLOT(elim_attempts, index);
+    unsigned long long idle = slot.state.load(ACQ);
+    unsigned long long tag = (idle + ELIM_TAG_ONE) & ELIM_TAG_MASK;  // Tag of this claim
+    if ((idle & ELIM_STATUS_MASK) != EMPTY || !cas(slot.state, idle, tag | BUSY, ACQ_REL)) {
+        elim_collision(state, eli_arr.size());  // Slot in use by another pair
+        return false;
+    }
+    slot.element = move(element);
+    unsigned long long offer = (seq << ELIM_SEQ_SHIFT) | tag | PUSH;
+    slot.state.store(offer, REL);        // Publish the offer
+    for (unsigned i = 0; i < state.spin && slot.state.load(ACQ) == offer; i++) {
+        cpu_relax();                     // Allow time for a matching dequeue
+    }
+    if (cas(slot.state, offer, tag | BUSY, ACQ_REL)) {
+        element = move(slot.element);    // Not taken, withdraw the offer
+        slot.state.store(tag | EMPTY, REL);
+        CONTENTION_SLOT(elim_timeouts, index);
+        elim_miss(state);
+        return false;
+    }
+    CONTENTION_SLOT(elim_hits, index);
+    elim_hit(state);
+    return true;  // A dequeue moved the element out, it resets the slot
+}
+
+// Take an offer whose seq is at most the seq of the dummy of an empty queue (head_seq); returns true on a match
+template <typename T>
+static bool eliminate_dequeue(vector<queue_elim_slot<T>> &eli_arr, T &element, unsigned long long head_seq) {
+    elim_thread_state &state = elim_local;
+    state.local.attempts++;
+    unsigned index = elim_pick(state, eli_arr.size());
+    queue_elim_slot<T> &slot = eli_arr[index];
+    CONTENTION_SLOT(elim_attempts, index);
+    unsigned long long offer = slot.state.load(ACQ);
+    unsigned long long status = offer & ELIM_STATUS_MASK;
+    if (status != PUSH) {
+        if (status == POP) {
+            elim_collision(state, eli_arr.size());  // Another dequeue got there first
+        } else {
+            elim_miss(state);                       // No offer in this slot
+        }
+        return false;
+    }
+    if ((offer >> ELIM_SEQ_SHIFT) > head_seq) {
+        state.local.young++;  // The enqueuer saw elements this dequeue has not seen leave, FIFO order forbids the match
+        return false;
+    }
+    if (!cas(slot.state, offer, (offer & ~ELIM_STATUS_MASK) | POP, ACQ_REL)) {
+        elim_collision(state, eli_arr.size());
+        return false;
+    }
+    element = move(slot.element);
+    slot.state.store((offer & ELIM_TAG_MASK) | EMPTY, REL);  // Reset the slot, keeping the tag
+    CONTENTION_SLOT(elim_hits, index);
+    elim_hit(state);
+    return true;
+}
+
+template <typename T, typename Reclaimer>
+mns_elim_queue<T, Reclaimer>::mns_elim_queue(int num) : eli_arr(num) {
+    seq_node<T> *dummy = new seq_node<T>();
+    head.store(dummy, RELAXED);
+    tail.store(dummy, RELAXED);
+}
+
+template <typename T, typename Reclaimer>
+void mns_elim_queue<T, Reclaimer>::insert_node(seq_node<T> *temp) {
+    typename Reclaimer::guard guard;  // Keeps the tail node alive while it is linked to
+    while (true) {
+        seq_node<T> *last = guard.protect(0, tail);
+        seq_node<T> *next = last->next.load(ACQ);
+        if (last != tail.load(ACQ)) {
+            continue;                 // Tail moved, the snapshot is stale
+        }
+
+        if (next == nullptr) {
+            temp->seq = last->seq + 1;
+            if (CONTENTION_CAS(PUSH, cas(last->next, next, temp, ACQ_REL))) {
+                cas(tail, last, temp, ACQ_REL);
+                gate.notify();
+                return;
+            }
+            // Lost the race for the tail: offer the element to a dequeue before retrying
+            if (eliminate_enqueue(eli_arr, temp->element, last->seq)) {
+                delete temp;
+                return;
+            }
+        } else {
+            cas(tail, last, next, ACQ_REL);  // Tail is lagging behind; advance it
+        }
+    }
+}
+
+template <typename T, typename Reclaimer>
+bool mns_elim_queue<T, Reclaimer>::remove(T &element) {
+    typename Reclaimer::guard guard;  // Keeps the head and its successor alive while they are read
+    while (true) {
+        seq_node<T> *temp = guard.protect(0, head);
+        seq_node<T> *last = tail.load(ACQ);
+        seq_node<T> *next_node = guard.protect(1, temp->next);
+        if (temp != head.load(ACQ)) {
+            continue;                 // Head moved, next_node may already be retired
+        }
+        if (!next_node) {
+            // Empty: an enqueue that is old enough can be matched right here
+            if (eliminate_dequeue(eli_arr, element, temp->seq)) {
+                return true;
+            }
+            CONTENTION_COUNT(empty_pops);
+            return false;
+        }
+        if (temp == last) {
+            cas(tail, last, next_node, ACQ_REL);  // Tail is lagging behind; help it before unlinking the head
+            continue;
+        }
+        if (CONTENTION_CAS(POP, cas(head, temp, next_node, ACQ_REL))) {
+            element = move(next_node->element);
+            Reclaimer::retire(temp, delete_node<seq_node<T>>);
+            return true;
+        }
+        // CAS failed, retry (a non-empty queue never eliminates, the head element comes first)
+    }
+}
+
+// Same as mns_queue::insert_chain, numbering the chain after the tail it is about to be linked to
+template <typename T, typename Reclaimer>
+void mns_elim_queue<T, Reclaimer>::insert_chain(seq_node<T> *first, seq_node<T> *last) {
+    typename Reclaimer::guard guard;
+    while (true) {
+        seq_node<T> *end = guard.protect(0, tail);
+        seq_node<T> *next = end->next.load(ACQ);
+        if (end != tail.load(ACQ)) {
+            continue;
+        }
+        if (next == nullptr) {
+            unsigned long long seq = end->seq;
+            for (seq_node<T> *temp = first; temp; temp = temp->next.load(RELAXED)) {
+                temp->seq = ++seq;
+            }
+            if (cas(end->next, next, first, ACQ_REL)) {
+                cas(tail, end, last, ACQ_REL);
+                gate.notify();
+                return;
+            }
+        } else {
+            cas(tail, end, next, ACQ_REL);
+        }
+    }
+}
+
+template <typename T, typename Reclaimer>
+size_t mns_elim_queue<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    size_t count = 0;
+    while (count < max && remove(out[count])) {
+        count++;
+    }
+    return count;
+}
+
+
+// Give up one hold on a node that has left the container (or, for a reservation, whose pop is done with it).
+// Data nodes and dummies have one holder, the thread that unlinks them. A reservation has two, the thread that
+// unlinks it and its waiting pop, and whichever finishes second retires it, so the pop can wait without a guard.
+template <typename T, typename Reclaimer>
+static void dual_release(dual_node<T> *node) {
+    if (node->holders.fetch_sub(1, ACQ_REL) == 1) {
+        Reclaimer::retire(node, delete_node<dual_node<T>>);
+    }
+}
+
+// Wait on the caller's own reservation until a push fulfills it or timeout_ns runs out (< 0: never), then
+// release it. Called outside any guard, so a long wait does not hold back reclamation (the epoch) for everyone.
+// Timed waits spin; an unbounded wait spins PARK_SPIN polls and then parks on the container's gate.
+// A reservation that runs out is cancelled, unless a push has claimed it already; then its element is on the way.
+template <typename T, typename Reclaimer>
+static bool dual_wait(dual_node<T> *mine, T &element, long long timeout_ns, park_gate &gate) {
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::nanoseconds(max(timeout_ns, 0ll));
+    unsigned spins = 0;
+    while (true) {
+        int state = mine->state.load(ACQ);
+        if (state == DUAL_FULFILLED) {
+            element = move(mine->element);
+            dual_release<T, Reclaimer>(mine);
+            return true;
+        }
+        if (state == DUAL_WAITING && timeout_ns >= 0 && spins % DUAL_CLOCK_INTERVAL == 0 &&
+            chrono::steady_clock::now() >= deadline && cas(mine->state, (int)DUAL_WAITING, (int)DUAL_CANCELLED, ACQ_REL)) {
+            CONTENTION_COUNT(empty_pops);
+            dual_release<T, Reclaimer>(mine);
+            return false;
+        }
+        if (timeout_ns < 0 && spins >= PARK_SPIN) {
+            unsigned key = gate.prepare_wait();
+            if (mine->state.load(ACQ) != DUAL_FULFILLED) {
+                gate.wait(key, PARK_FOREVER);  // dual_fulfill notifies after publishing the element
+            }
+            continue;
+        }
+        if (++spins % DUAL_YIELD_INTERVAL == 0) {
+            this_thread::yield();
+        } else {
+            cpu_relax();
+        }
+    }
+}
+
+// Hand the element of a data node to a waiting reservation. Fails if the reservation is no longer waiting.
+template <typename T>
+static bool dual_fulfill(dual_node<T> *request, dual_node<T> *temp, park_gate &gate) {
+    if (!cas(request->state, (int)DUAL_WAITING, (int)DUAL_CLAIMED, ACQ_REL)) {
+        return false;
+    }
+    request->element = move(temp->element);
+    request->state.store(DUAL_FULFILLED, REL);  // The waiting pop may take the element now
+    gate.notify();  // Wake it if it has parked
+    delete temp;  // Never linked
+    return true;
+}
+
+template <typename T, typename Reclaimer>
+void dual_stack<T, Reclaimer>::push_node(dual_node<T> *temp) {
+    typename Reclaimer::guard guard;  // Keeps the top node alive while its state and next are read
+    while (true) {
+        dual_node<T> *old_top = guard.protect(0, top);
+        if (!old_top || !old_top->request) {
+            temp->next.store(old_top, RELAXED);  // Empty or data: a plain Treiber push
+            if (CONTENTION_CAS(PUSH, cas(top, old_top, temp, ACQ_REL))) {
+                return;
+            }
+            continue;
+        }
+        // Reservations on top: fulfill the top one, then unlink it (or let the next thread that sees it do so)
+        bool served = dual_fulfill(old_top, temp, gate);
+        if (cas(top, old_top, old_top->next.load(RELAXED), ACQ_REL)) {
+            dual_release<T, Reclaimer>(old_top);
+        }
+        if (served) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename Reclaimer>
+bool dual_stack<T, Reclaimer>::take(T &element, bool reserve, long long timeout_ns) {
+    dual_node<T> *mine = nullptr;
+    {
+        typename Reclaimer::guard guard;  // Keeps the top node alive; our reservation is kept alive by its second holder
+        while (true) {
+            dual_node<T> *old_top = guard.protect(0, top);
+            if (old_top && !old_top->request) {
+                if (CONTENTION_CAS(POP, cas(top, old_top, old_top->next.load(RELAXED), ACQ_REL))) {  // Data: a plain Treiber pop
+                    element = move(old_top->element);
+                    Reclaimer::retire(old_top, delete_node<dual_node<T>>);
+                    delete mine;  // Never linked
+                    return true;
+                }
+                continue;
+            }
+            if (old_top && old_top->state.load(ACQ) != DUAL_WAITING) {
+                if (cas(top, old_top, old_top->next.load(RELAXED), ACQ_REL)) {  // Dead reservation: unlink it first
+                    dual_release<T, Reclaimer>(old_top);
+                }
+                continue;
+            }
+            if (!reserve) {
+                delete mine;
+                CONTENTION_COUNT(empty_pops);
+                return false;
+            }
+            // Empty or live reservations only: push our own and wait on it
+            if (!mine) {
+                mine = new dual_node<T>();
+                mine->holders.store(2, RELAXED);  // Released by the thread that unlinks it and by us
+            }
+            mine->next.store(old_top, RELAXED);
+            if (cas(top, old_top, mine, ACQ_REL)) {
+                break;
+            }
+        }
+    }
+    return dual_wait<T, Reclaimer>(mine, element, timeout_ns, gate);  // Outside the guard
+}
+
+template <typename T, typename Reclaimer>
+size_t dual_stack<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    size_t count = 0;
+    while (count < max && take(out[count], false, 0)) {
+        count++;
+    }
+    return count;
+}
+
+template <typename T, typename Reclaimer>
+dual_queue<T, Reclaimer>::dual_queue() {
+    dual_node<T> *dummy = new dual_node<T>();
+    head.store(dummy, RELAXED);
+    tail.store(dummy, RELAXED);
+}
+
+// The queue holds either data or reservations behind the dummy. An insert appends when the queue is empty
+// or holds data; otherwise it fulfills the reservation behind the dummy, which then becomes the new dummy.
+template <typename T, typename Reclaimer>
+void dual_queue<T, Reclaimer>::insert_node(dual_node<T> *temp) {
+    typename Reclaimer::guard guard;
+    while (true) {
+        dual_node<T> *last = guard.protect(0, tail);
+        dual_node<T> *first = head.load(ACQ);
+        if (first == last || !last->request) {
+            // Empty or data: the M&S enqueue
+            dual_node<T> *next = last->next.load(ACQ);
+            if (last != tail.load(ACQ)) {
+                continue;
+            }
+            if (next) {
+                cas(tail, last, next, ACQ_REL);  // Tail is lagging behind; advance it
+                continue;
+            }
+            if (CONTENTION_CAS(PUSH, cas(last->next, next, temp, ACQ_REL))) {
+                cas(tail, last, temp, ACQ_REL);
+                return;
+            }
+            continue;
+        }
+        // Reservations: serve the front one
+        first = guard.protect(0, head);
+        last = tail.load(ACQ);
+        dual_node<T> *next = guard.protect(1, first->next);
+        if (first != head.load(ACQ)) {
+            continue;                  // Head moved, next may already be retired
+        }
+        if (!next || !next->request) {
+            continue;                  // Drained or turned into a data queue meanwhile
+        }
+        if (first == last) {
+            cas(tail, last, next, ACQ_REL);  // Tail is lagging behind; help it before moving head
+            continue;
+        }
+        bool served = dual_fulfill(next, temp, gate);
+        if (cas(head, first, next, ACQ_REL)) {  // Fulfilled or dead either way: next becomes the dummy
+            dual_release<T, Reclaimer>(first);
+        }
+        if (served) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename Reclaimer>
+bool dual_queue<T, Reclaimer>::take(T &element, bool reserve, long long timeout_ns) {
+    dual_node<T> *mine = nullptr;
+    {
+        typename Reclaimer::guard guard;  // Keeps the nodes we read alive; our reservation is kept alive by its second holder
+        while (true) {
+            dual_node<T> *last = guard.protect(0, tail);
+            dual_node<T> *first = head.load(ACQ);
+            if (first == last || last->request) {
+                // Empty or reservations: append ours and wait on it
+                dual_node<T> *next = last->next.load(ACQ);
+                if (last != tail.load(ACQ)) {
+                    continue;
+                }
+                if (next) {
+                    cas(tail, last, next, ACQ_REL);
+                    continue;
+                }
+                if (!reserve) {
+                    delete mine;
+                    CONTENTION_COUNT(empty_pops);
+                    return false;
+                }
+                if (!mine) {
+                    mine = new dual_node<T>();
+                    mine->holders.store(2, RELAXED);  // Released by the thread that moves head past it and by us
+                }
+                if (cas(last->next, next, mine, ACQ_REL)) {
+                    cas(tail, last, mine, ACQ_REL);
+                    break;
+                }
+                continue;
+            }
+            // Data: the M&S dequeue
+            first = guard.protect(0, head);
+            last = tail.load(ACQ);
+            dual_node<T> *next = guard.protect(1, first->next);
+            if (first != head.load(ACQ)) {
+                continue;
+            }
+            if (!next || next->request) {
+                continue;                  // Drained or turned into a reservation queue meanwhile
+            }
+            if (first == last) {
+                cas(tail, last, next, ACQ_REL);
+                continue;
+            }
+            if (CONTENTION_CAS(POP, cas(head, first, next, ACQ_REL))) {
+                element = move(next->element);  // next becomes the dummy
+                dual_release<T, Reclaimer>(first);
+                delete mine;  // Never linked
+                return true;
+            }
+        }
+    }
+    return dual_wait<T, Reclaimer>(mine, element, timeout_ns, gate);  // Outside the guard
+}
+
+template <typename T, typename Reclaimer>
+size_t dual_queue<T, Reclaimer>::pop_bulk(T *out, size_t max) {
+    size_t count = 0;
+    while (count < max && take(out[count], false, 0)) {
+        count++;
+    }
+    return count;
+}
+
+
+// Thread indices for the publication records, handed back when the thread exits
+static atomic<bool> fc_index_used[MAX_THREADS];
+
+struct fc_thread_slot {
+    int index = -1;
+    ~fc_thread_slot() {
+        if (index >= 0) {
+            fc_index_used[index].store(false, REL);
+        }
+    }
+};
+
+static thread_local fc_thread_slot fc_slot;
+
+int fc_thread_index() {
+    if (fc_slot.index < 0) {
+        for (int i = 0; i < MAX_THREADS; i++) {
+            if (!fc_index_used[i].load(RELAXED) && cas(fc_index_used[i], false, true, ACQ_REL)) {
+                fc_slot.index = i;
+                return i;
+            }
+        }
+        // Not reached from the drivers: command_handle rejects more than MAX_THREADS threads before any starts
+        cout << "Publication records are full, increase MAX_THREADS (" << MAX_THREADS << ")" << endl;
+        exit(EXIT_FAILURE);
+    }
+    return fc_slot.index;
+}
+
+template <typename T, typename Lock>
+void flat_combiner<T, Lock>::enlist(fc_record<T> &rec) {
+    rec.active.store(true, RELAXED);
+    fc_record<T> *old_head = pub_head.load(ACQ);
+    do {
+        rec.next.store(old_head, RELAXED);
+    } while (!pub_head.compare_exchange_weak(old_head, &rec, ACQ_REL));
+}
+
+// Each pass over the publication list collects the pending requests, applies them and releases their owners.
+// The combiner stops after a pass that found nothing or after FC_MAX_PASSES passes, so it is never stuck
+// serving a steady stream of requests. Every FC_CLEANUP_INTERVAL passes it also unlinks records that have
+// been idle for FC_AGE_LIMIT passes; the head record is never unlinked because enlist CASes on pub_head.
+template <typename T, typename Lock>
+void flat_combiner<T, Lock>::combine(fc_apply<T> apply, void *container) {
+    fc_record<T> *pending[MAX_THREADS];
+    CONTENTION_COUNT(combiner_sessions);
+    for (int round = 0; round < FC_MAX_PASSES; round++) {
+        unsigned pass = ++passes;
+        bool cleanup = pass % FC_CLEANUP_INTERVAL == 0;
+        size_t count = 0;
+        fc_record<T> *prev = nullptr;
+        fc_record<T> *rec = pub_head.load(ACQ);
+        while (rec) {
+            fc_record<T> *next = rec->next.load(ACQ);
+            if (rec->request.load(ACQ) != FC_NONE) {
+                rec->age = pass;
+                pending[count++] = rec;
+                prev = rec;
+            } else if (cleanup && prev && pass - rec->age > FC_AGE_LIMIT) {
+                prev->next.store(next, REL);    // Unlink first: the owner only re-enlists once active is false
+                rec->active.store(false, REL);
+            } else {
+                prev = rec;
+            }
+            rec = next;
+        }
+        if (count == 0) {
+            return;
+        }
+        CONTENTION_BATCH(count);
+        apply(container, pending, count);
+        for (size_t i = 0; i < count; i++) {
+            pending[i]->request.store(FC_NONE, REL);  // Hands element/result back to the owner
+        }
+    }
+}
+
+template <typename T, typename Lock>
+void flat_combiner<T, Lock>::execute(fc_record<T> &rec, int request, fc_apply<T> apply, void *container) {
+    typename Lock::node qnode;
+    rec.request.store(request, REL);
+    while (true) {
+        if (!rec.active.load(ACQ)) {
+            enlist(rec);  // First request, or the record was evicted for being idle
+        }
+        if (lock.try_lock(qnode)) {
+            combine(apply, container);  // Our record is in the list, so this serves our request as well
+            release(qnode);
+            return;
+        }
+        // Another thread is combining: watch our own record only
+        for (int spin = 0; spin < FC_SPIN; spin++) {
+            if (rec.request.load(ACQ) == FC_NONE) {
+                return;
+            }
+            CONTENTION_COUNT(lock_spins);
+            cpu_relax();
+        }
+        if (rec.request.load(ACQ) == FC_NONE) {
+            return;
+        }
+        this_thread::yield();  // The combiner may be descheduled
+    }
+}
+
+template <typename T, typename Lock>
+void flat_combiner<T, Lock>::acquire(typename Lock::node &n, fc_apply<T> apply, void *container) {
+    lock.lock(n);
+    combine(apply, container);
+}
+
+template <typename T, typename Lock>
+bool queue_flat<T, Lock>::remove(T &element) {
+    fc_record<T> &rec = fc.my_record();
+    fc.execute(rec, FC_POP, apply, this);
+    if (rec.result) {
+        element = move(rec.element);
+    }
+    return rec.result;
+}
+
+template <typename T, typename Lock>
+void queue_flat<T, Lock>::apply(void *self, fc_record<T> **pending, size_t count) {
+    queue_flat<T, Lock> *q = static_cast<queue_flat<T, Lock> *>(self);
+    for (size_t i = 0; i < count; i++) {
+        fc_record<T> *rec = pending[i];
+        if (rec->request.load(RELAXED) == FC_PUSH) {
+            queue_node<T> *temp = new queue_node<T>(move(rec->element));
+            if (q->tail) {
+                q->tail->next = temp;
+            } else {
+                q->head = temp;
+            }
+            q->tail = temp;
+        } else if (q->head) {
+            queue_node<T> *temp = q->head;
+            rec->element = move(temp->element);
+            rec->result = true;
+            q->head = temp->next;
+            if (!q->head) {
+                q->tail = nullptr;
+            }
+            delete temp;
+        } else {
+            rec->result = false;  // Empty
+        }
+    }
+}
+
+template <typename T, typename Lock>
+bool stack_flat<T, Lock>::pop(T &element) {
+    fc_record<T> &rec = fc.my_record();
+    fc.execute(rec, FC_POP, apply, this);
+    if (rec.result) {
+        element = move(rec.element);
+    }
+    return rec.result;
+}
+
+// Split the requests into pushes and pops, hand the first pushes straight to the first pops (a push and
+// a pop that are pending together can be linearized back to back), then apply whatever is left over
+template <typename T, typename Lock>
+void stack_flat<T, Lock>::apply(void *self, fc_record<T> **pending, size_t count) {
+    stack_flat<T, Lock> *s = static_cast<stack_flat<T, Lock> *>(self);
+    fc_record<T> *pushes[MAX_THREADS];
+    fc_record<T> *pops[MAX_THREADS];
+    size_t num_pushes = 0;
+    size_t num_pops = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pending[i]->request.load(RELAXED) == FC_PUSH) {
+            pushes[num_pushes++] = pending[i];
+        } else {
+            pops[num_pops++] = pending[i];
+        }
+    }
+
+    size_t pairs = min(num_pushes, num_pops);
+    for (size_t i = 0; i < pairs; i++) {
+        pops[i]->element = move(pushes[i]->element);
+        pops[i]->result = true;
+    }
+    for (size_t i = pairs; i < num_pushes; i++) {
+        s->top = new stack_node<T>(move(pushes[i]->element), s->top);
+    }
+    for (size_t i = pairs; i < num_pops; i++) {
+        stack_node<T> *temp = s->top;
+        if (!temp) {
+            pops[i]->result = false;  // Empty
+            continue;
+        }
+        pops[i]->element = move(temp->element);
+        pops[i]->result = true;
+        s->top = temp->next;
+        delete temp;
+    }
+}
+
+template <typename T, typename Lock>
+void stack_flat<T, Lock>::push_chain(stack_node<T> *first, stack_node<T> *last) {
+    typename Lock::node qnode;
+    fc.acquire(qnode, apply, this);
+    last->next = top;
+    top = first;
+    fc.release(qnode);
+    gate.notify();
+}
+
+template <typename T, typename Lock>
+size_t stack_flat<T, Lock>::pop_bulk(T *out, size_t max) {
+    typename Lock::node qnode;
+    fc.acquire(qnode, apply, this);
+    size_t count = 0;
+    while (count < max && top) {
+        stack_node<T> *temp = top;
+        out[count++] = move(temp->element);
+        top = temp->next;
+        delete temp;
+    }
+    fc.release(qnode);
+    return count;
+}
+
+template <typename T, typename Lock>
+void queue_flat<T, Lock>::insert_chain(queue_node<T> *first, queue_node<T> *last) {
+    typename Lock::node qnode;
+    fc.acquire(qnode, apply, this);
+    if (tail) {
+        tail->next = first;
+    } else {
+        head = first;
+    }
+    tail = last;
+    fc.release(qnode);
+    gate.notify();
+}
+
+template <typename T, typename Lock>
+size_t queue_flat<T, Lock>::pop_bulk(T *out, size_t max) {
+    typename Lock::node qnode;
+    fc.acquire(qnode, apply, this);
+    size_t count = 0;
+    while (count < max && head) {
+        queue_node<T> *temp = head;
+        out[count++] = move(temp->element);
+        head = temp->next;
+        delete temp;
+    }
+    if (!head) {
+        tail = nullptr;
+    }
+    fc.release(qnode);
+    return count;
+}
+
+// xorshift state for the shard choices of the relaxed containers
+static thread_local uint32_t multi_seed = 0;
+
+static uint32_t multi_random() {
+    if (multi_seed == 0) {
+        multi_seed = (uint32_t)hash<thread::id>()(this_thread::get_id()) | 1;
+    }
+    multi_seed ^= multi_seed << 13;
+    multi_seed ^= multi_seed >> 17;
+    multi_seed ^= multi_seed << 5;
+    return multi_seed;
+}
+
+// Power of two choices: the smaller (for a push) or larger (for a pop) of two random shards
+template <typename Shard>
+static size_t multi_pick(vector<multi_shard<Shard>> &shards, bool smaller) {
+    size_t a = multi_random() % shards.size();
+    size_t b = multi_random() % shards.size();
+    long long size_a = shards[a].size.load(RELAXED);
+    long long size_b = shards[b].size.load(RELAXED);
+    return (smaller ? size_a <= size_b : size_a >= size_b) ? a : b;
+}
+
+// Pop from shard first, or from the next non-empty shard after it; returns the shard used or shards.size() if all were empty.
+// The scan only reads the size of the other shards, so an empty container costs loads rather than a CAS per shard.
+template <typename Shard, typename T>
+static size_t multi_take(vector<multi_shard<Shard>> &shards, size_t first, multi_item<T> &item) {
+    for (size_t i = 0; i < shards.size(); i++) {
+        size_t index = (first + i) % shards.size();
+        if (i > 0 && shards[index].size.load(RELAXED) <= 0) {
+            continue;
+        }
+        bool popped;
+        if constexpr (requires { shards[index].buffer.pop(item); }) {
+            popped = shards[index].buffer.pop(item);
+        } else {
+            popped = shards[index].buffer.remove(item);
+        }
+        if (popped) {
+            shards[index].size.fetch_sub(1, RELAXED);
+            return index;
+        }
+    }
+    return shards.size();
+}
+
+template <typename T>
+size_t multi_stack<T>::pick_push() {
+    return multi_pick(shards, true);
+}
+
+template <typename T>
+size_t multi_stack<T>::pick_pop() {
+    return multi_pick(shards, false);
+}
+
+template <typename T>
+bool multi_stack<T>::pop(T &element) {
+    multi_item<T> item;
+    if (multi_take(shards, pick_pop(), item) == shards.size()) {
+        return false;  // Every shard was empty
+    }
+    element = move(item.element);
+    if (item.seq) {
+        ranks.record_pop(item.seq);
+    }
+    return true;
+}
+
+// Detach up to max elements from the larger of two shards; falls back to a single scanning pop if it was empty
+template <typename T>
+size_t multi_stack<T>::pop_bulk(T *out, size_t max) {
+    static thread_local vector<multi_item<T>> items;  // Reused across calls: no allocation per batch
+    if (items.size() < max) {
+        items.resize(max);
+    }
+    multi_shard<treiber_stack<multi_item<T>>> &shard = shards[pick_pop()];
+    size_t count = shard.buffer.pop_bulk(items.data(), max);
+    if (count == 0) {
+        return max > 0 && pop(out[0]) ? 1 : 0;
+    }
+    shard.size.fetch_sub(count, RELAXED);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = move(items[i].element);
+        if (items[i].seq) {
+            ranks.record_pop(items[i].seq);
+        }
+    }
+    return count;
+}
+
+template <typename T>
+size_t multi_queue<T>::pick_push() {
+    return multi_pick(shards, true);
+}
+
+template <typename T>
+size_t multi_queue<T>::pick_pop() {
+    return multi_pick(shards, false);
+}
+
+template <typename T>
+bool multi_queue<T>::remove(T &element) {
+    multi_item<T> item;
+    if (multi_take(shards, pick_pop(), item) == shards.size()) {
+        return false;  // Every shard was empty
+    }
+    element = move(item.element);
+    if (item.seq) {
+        ranks.record_pop(item.seq);
+    }
+    return true;
+}
+
+template <typename T>
+size_t multi_queue<T>::pop_bulk(T *out, size_t max) {
+    static thread_local vector<multi_item<T>> items;  // Reused across calls: no allocation per batch
+    if (items.size() < max) {
+        items.resize(max);
+    }
+    multi_shard<mns_queue<multi_item<T>>> &shard = shards[pick_pop()];
+    size_t count = shard.buffer.pop_bulk(items.data(), max);
+    if (count == 0) {
+        return max > 0 && remove(out[0]) ? 1 : 0;
+    }
+    shard.size.fetch_sub(count, RELAXED);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = move(items[i].element);
+        if (items[i].seq) {
+            ranks.record_pop(items[i].seq);
+        }
+    }
+    return count;
+}
+
+void rank_log::record_push(unsigned long long seq) {
+    events[fc_thread_index()].push_back({seq, seq});
+}
+
+void rank_log::record_pop(unsigned long long seq) {
+    events[fc_thread_index()].push_back({clock.fetch_add(1, ACQ_REL), seq});
+}
+
+// Fenwick tree over push tickets: counts the elements still in the container
+static void fenwick_add(vector<long long> &tree, unsigned long long index, long long delta) {
+    for (; index < tree.size(); index += index & -index) {
+        tree[index] += delta;
+    }
+}
+
+static long long fenwick_sum(vector<long long> &tree, unsigned long long index) {
+    long long sum = 0;
+    for (; index > 0; index -= index & -index) {
+        sum += tree[index];
+    }
+    return sum;
+}
+
+// Replay pushes and pops in clock order. The rank error of a pop is the number of elements still in the container
+// that a strict container would have returned instead: pushed later (LIFO) or earlier (FIFO) than the one popped.
+rank_error_stats rank_log::compute(bool lifo) {
+    rank_error_stats stats = {0, 0.0, 0};
+    vector<rank_event> all;
+    for (size_t i = 0; i < events.size(); i++) {
+        all.insert(all.end(), events[i].begin(), events[i].end());
+    }
+    sort(all.begin(), all.end(), [](const rank_event &a, const rank_event &b) { return a.ticket < b.ticket; });
+    vector<long long> tree(clock.load(ACQ) + 1, 0);
+    long long present = 0;
+    double total = 0;
+    for (size_t i = 0; i < all.size(); i++) {
+        if (all[i].ticket == all[i].seq) {
+            fenwick_add(tree, all[i].seq, 1);  // Push
+            present++;
+            continue;
+        }
+        long long older = fenwick_sum(tree, all[i].seq - 1);
+        unsigned long long error = lifo ? present - older - 1 : older;
+        fenwick_add(tree, all[i].seq, -1);
+        present--;
+        stats.pops++;
+        total += error;
+        stats.max = max(stats.max, error);
+    }
+    stats.mean = stats.pops ? total / stats.pops : 0.0;
+    return stats;
+}
+
+
+// Work-stealing counters, kept per thread and added to the totals when the thread exits
+struct ws_thread_state {
+    ws_stats local = {0, 0};  // Counters not yet added to the totals
+
+    ~ws_thread_state();
+};
+
+static atomic<unsigned long long> total_ws_attempts(0);
+static atomic<unsigned long long> total_ws_steals(0);
+static thread_local ws_thread_state ws_local;
+
+ws_thread_state::~ws_thread_state() {
+    total_ws_attempts.fetch_add(local.attempts, RELAXED);
+    total_ws_steals.fetch_add(local.steals, RELAXED);
+}
+
+ws_stats ws_get_stats() {
+    return {total_ws_attempts.load(RELAXED) + ws_local.local.attempts,
+            total_ws_steals.load(RELAXED) + ws_local.local.steals};
+}
+
+template <typename T>
+ws_deque<T>::~ws_deque() {
+    delete ring.load(RELAXED);
+    for (size_t i = 0; i < old_rings.size(); i++) {
+        delete old_rings[i];
+    }
+}
+
+template <typename T>
+ws_ring<T> *ws_deque<T>::grow(ws_ring<T> *old, long long b, long long t) {
+    ws_ring<T> *bigger = new ws_ring<T>(old->capacity() * 2);
+    for (long long i = t; i < b; i++) {
+        bigger->at(i) = old->at(i);
+    }
+    old_rings.push_back(old);  // A thief that loaded the old ring may still copy from it
+    ring.store(bigger, REL);
+    return bigger;
+}
+
+template <typename T>
+void ws_deque<T>::push(const T &element) {
+    long long b = bottom.load(RELAXED);
+    long long t = top.load(ACQ);
+    ws_ring<T> *r = ring.load(RELAXED);
+    if (b - t > (long long)r->capacity() - 1) {
+        r = grow(r, b, t);  // Full
+    }
+    r->at(b) = element;
+    atomic_thread_fence(REL);  // Publish the element before the new bottom
+    bottom.store(b + 1, RELAXED);
+}
+
+template <typename T>
+bool ws_deque<T>::pop(T &element) {
+    long long b = bottom.load(RELAXED) - 1;
+    ws_ring<T> *r = ring.load(RELAXED);
+    bottom.store(b, RELAXED);  // Reserve the bottom element before looking at top
+    atomic_thread_fence(SEQCST);  // Pairs with the fence in steal: a thief and the owner cannot both miss each other
+    long long t = top.load(RELAXED);
+    if (t > b) {
+        bottom.store(b + 1, RELAXED);  // Empty
+        CONTENTION_COUNT(empty_pops);
+        return false;
+    }
+    element = r->at(b);
+    if (t == b) {
+        // Last element: race the thieves for it on top
+        bool won = CONTENTION_CAS(POP, cas(top, t, t + 1, SEQCST));
+        bottom.store(b + 1, RELAXED);
+        return won;
+    }
+    return true;
+}
+
+template <typename T>
+bool ws_deque<T>::steal(T &element) {
+    long long t = top.load(ACQ);
+    atomic_thread_fence(SEQCST);
+    long long b = bottom.load(ACQ);
+    if (t >= b) {
+        CONTENTION_COUNT(empty_pops);
+        return false;  // Empty
+    }
+    ws_local.local.attempts++;
+    ws_ring<T> *r = ring.load(ACQ);
+    element = r->at(t);  // Speculative copy, only kept if the CAS below wins position t
+    if (!CONTENTION_CAS(POP, cas(top, t, t + 1, SEQCST))) {
+        return false;  // Another thief or the owner's last pop took it
+    }
+    ws_local.local.steals++;
+    return true;
+}
+
+// Level of a new skiplist node: 1 + the number of trailing one bits of a random word, so level l has
+// probability 2^-l, capped at PQ_MAX_LEVEL
+static thread_local uint32_t pq_seed = 0;
+
+static int pq_random_level() {
+    if (!pq_seed) {
+        pq_seed = (uint32_t)(uintptr_t)&pq_seed | 1;  // Distinct per thread, never 0
+    }
+    pq_seed ^= pq_seed << 13;
+    pq_seed ^= pq_seed >> 17;
+    pq_seed ^= pq_seed << 5;
+    int level = 1;
+    for (uint32_t bits = pq_seed; (bits & 1) && level < PQ_MAX_LEVEL; bits >>= 1) {
+        level++;
+    }
+    return level;
+}
+
+template <typename T, typename Reclaimer>
+skiplist_pq<T, Reclaimer>::skiplist_pq() {
+    head = pq_node<T>::create(T(), PQ_MAX_LEVEL);
+    tail = pq_node<T>::create(T(), 1);
+    head->inserting.store(false, RELAXED);
+    tail->inserting.store(false, RELAXED);
+    for (int i = 0; i < PQ_MAX_LEVEL; i++) {
+        head->next[i].store((uintptr_t)tail, RELAXED);
+    }
+}
+
+template <typename T, typename Reclaimer>
+skiplist_pq<T, Reclaimer>::~skiplist_pq() {
+    // Nodes cut off before were retired; everything still linked at level 0 (including the prefix) is freed here
+    pq_node<T> *cur = head;
+    while (cur != tail) {
+        pq_node<T> *next = pq_unmark<T>(cur->next[0].load(RELAXED));
+        pq_node<T>::destroy(cur);
+        cur = next;
+    }
+    pq_node<T>::destroy(tail);
+}
+
+template <typename T, typename Reclaimer>
+pq_node<T> *skiplist_pq<T, Reclaimer>::locate_preds(const T &key, pq_node<T> **preds, pq_node<T> **succs) {
+    pq_node<T> *pred = head;
+    pq_node<T> *del = nullptr;  // Last deleted node passed at level 0
+    for (int i = PQ_MAX_LEVEL - 1; i >= 0; i--) {
+        uintptr_t link = pred->next[i].load(ACQ);
+        pq_node<T> *cur = pq_unmark<T>(link);
+        // Skip smaller keys and every node of the deleted prefix: a node whose successor is deleted is deleted
+        // itself, and at level 0 the last deleted node is recognised by its marked incoming link. The mark has
+        // to come from the same load as cur, or an insert plus a delete_min in between would mark the wrong node.
+        while (before(cur, key) || (cur->next[0].load(ACQ) & PQ_DELETED) || (i == 0 && (link & PQ_DELETED))) {
+            if (i == 0 && (link & PQ_DELETED)) {
+                del = cur;
+            }
+            pred = cur;
+            link = pred->next[i].load(ACQ);
+            cur = pq_unmark<T>(link);
+        }
+        preds[i] = pred;
+        succs[i] = cur;
+    }
+    return del;
+}
+
+template <typename T, typename Reclaimer>
+void skiplist_pq<T, Reclaimer>::insert(const T &key) {
+    [[maybe_unused]] typename Reclaimer::guard guard;  // Keeps every node of the walk alive (EBR); the leak guard does nothing
+    int level = pq_random_level();
+    pq_node<T> *temp = pq_node<T>::create(key, level);
+    pq_node<T> *preds[PQ_MAX_LEVEL];
+    pq_node<T> *succs[PQ_MAX_LEVEL];
+    pq_node<T> *del;
+
+    // Level 0 decides membership: fails if the predecessor's link changed or got marked
+    do {
+        del = locate_preds(key, preds, succs);
+        temp->next[0].store((uintptr_t)succs[0], RELAXED);
+    } while (!CONTENTION_CAS(PUSH, cas(preds[0]->next[0], (uintptr_t)succs[0], (uintptr_t)temp, ACQ_REL)));
+
+    // Upper levels are only shortcuts; stop as soon as the node (or the successor) has been deleted
+    for (int i = 1; i < level; ) {
+        if (del && del == succs[i]) {
+            // The walk on this level stopped at the last deleted node, which temp follows on level 0. Giving up
+            // the level here (as in the paper) leaves every key inserted after a full drain on level 0 only, so
+            // link it behind the deleted node instead.
+            pq_node<T> *pred = del;
+            pq_node<T> *cur = pq_unmark<T>(pred->next[i].load(ACQ));
+            while (before(cur, key) || (cur->next[0].load(ACQ) & PQ_DELETED)) {
+                pred = cur;
+                cur = pq_unmark<T>(pred->next[i].load(ACQ));
+            }
+            preds[i] = pred;
+            succs[i] = cur;
+        }
+        temp->next[i].store((uintptr_t)succs[i], RELAXED);
+        if ((temp->next[0].load(ACQ) & PQ_DELETED) || (succs[i]->next[0].load(ACQ) & PQ_DELETED)) {
+            break;
+        }
+        if (cas(preds[i]->next[i], (uintptr_t)succs[i], (uintptr_t)temp, ACQ_REL)) {
+            i++;
+        } else {
+            del = locate_preds(key, preds, succs);
+            if (succs[0] != temp) {
+                break;  // temp was deleted meanwhile
+            }
+        }
+    }
+    temp->inserting.store(false, REL);
+}
+
+template <typename T, typename Reclaimer>
+bool skiplist_pq<T, Reclaimer>::delete_min(T &key) {
+    [[maybe_unused]] typename Reclaimer::guard guard;  // Keeps every node of the walk alive (EBR); the leak guard does nothing
+    pq_node<T> *x = head;
+    pq_node<T> *newhead = nullptr;  // Where a cut may move head to: the first node still being inserted, or x
+    uintptr_t observed = head->next[0].load(ACQ);
+    int offset = 0;
+    uintptr_t next;
+
+    // Walk the deleted prefix; the first fetch_or that finds its link unmarked deletes the node behind it
+    do {
+        next = x->next[0].load(ACQ);
+        if (pq_unmark<T>(next) == tail) {
+            CONTENTION_COUNT(empty_pops);
+            return false;  // Empty
+        }
+        if (!newhead && x->inserting.load(ACQ)) {
+            newhead = x;
+        }
+        next = x->next[0].fetch_or(PQ_DELETED, ACQ_REL);
+        (void)CONTENTION_CAS(POP, !(next & PQ_DELETED));  // A set mark means another delete_min got this node
+        offset++;
+        x = pq_unmark<T>(next);
+    } while (next & PQ_DELETED);
+    key = x->key;
+    if (offset < PQ_BOUND_OFFSET) {
+        return true;
+    }
+
+    // Long prefix: unlink it in one step, fix head's upper levels, then retire the nodes cut off
+    if (!newhead) {
+        newhead = x;
+    }
+    if (cas(head->next[0], observed, (uintptr_t)newhead | PQ_DELETED, ACQ_REL)) {
+        restructure();
+        pq_node<T> *cur = pq_unmark<T>(observed);
+        while (cur != newhead) {
+            pq_node<T> *succ = pq_unmark<T>(cur->next[0].load(ACQ));
+            Reclaimer::retire(cur, pq_node<T>::destroy);
+            cur = succ;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename Reclaimer>
+void skiplist_pq<T, Reclaimer>::restructure() {
+    pq_node<T> *pred = head;
+    for (int i = PQ_MAX_LEVEL - 1; i > 0; ) {
+        uintptr_t first = head->next[i].load(ACQ);
+        if (!(pq_unmark<T>(first)->next[0].load(ACQ) & PQ_DELETED)) {
+            i--;  // head already points past the prefix on this level
+            continue;
+        }
+        pq_node<T> *cur = pq_unmark<T>(pred->next[i].load(ACQ));
+        while (cur->next[0].load(ACQ) & PQ_DELETED) {
+            pred = cur;
+            cur = pq_unmark<T>(pred->next[i].load(ACQ));
+        }
+        if (cas(head->next[i], first, pred->next[i].load(ACQ), ACQ_REL)) {
+            i--;
+        }
+    }
+}
+
+// Explicit instantiations: every container for int, the 64-byte message and a move-only handle,
+// the lock-free ones for every reclamation policy selectable with --reclaim and the lock-based ones for every --lock
+#define INSTANTIATE_RECLAIMED(container, type) \
+    template class container<type, leak_reclaimer>; \
+    template class container<type, hazard_pointer_reclaimer>; \
+    template class container<type, epoch_reclaimer>;
+
+#define INSTANTIATE_LOCKED(container, type) \
+    template class container<type, tas_lock>; \
+    template class container<type, ttas_lock>; \
+    template class container<type, ticket_lock>; \
+    template class container<type, mcs_lock>; \
+    template class container<type, clh_lock>;
+
+#define INSTANTIATE_CONTAINERS(type) \
+    INSTANTIATE_LOCKED(stack, type) \
+    INSTANTIATE_LOCKED(queue, type) \
+    INSTANTIATE_LOCKED(stack_elim, type) \
+    INSTANTIATE_LOCKED(stack_flat, type) \
+    INSTANTIATE_LOCKED(queue_flat, type) \
+    INSTANTIATE_LOCKED(twolock_queue, type) \
+    template class treiber_stack_tagged<type>; \
+    template class ring_queue<type>; \
+    template class spsc_queue<type>; \
+    INSTANTIATE_RECLAIMED(treiber_stack, type) \
+    INSTANTIATE_RECLAIMED(mns_queue, type) \
+    INSTANTIATE_RECLAIMED(faa_queue, type) \
+    INSTANTIATE_RECLAIMED(mns_elim_queue, type) \
+    INSTANTIATE_RECLAIMED(treiber_stack_elim, type) \
+    INSTANTIATE_RECLAIMED(dual_stack, type) \
+    INSTANTIATE_RECLAIMED(dual_queue, type) \
+    template class treiber_stack<multi_item<type>>; \
+    template class mns_queue<multi_item<type>>; \
+    template class multi_stack<type>; \
+    template class multi_queue<type>;
+
+INSTANTIATE_CONTAINERS(int)
+INSTANTIATE_CONTAINERS(message)
+INSTANTIATE_CONTAINERS(unique_ptr<message>)
+
+// The work-stealing deque copies elements speculatively, so it exists for the trivially copyable types only
+template class ws_deque<int>;
+template class ws_deque<message>;
+
+// The priority queue orders its keys, so it exists for int only; HP cannot protect its walks (see buffer.hpp)
+template class skiplist_pq<int, leak_reclaimer>;
+template class skiplist_pq<int, epoch_reclaimer>;
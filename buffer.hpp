@@ -1,131 +1,1295 @@
-#include <atomic> // Include atomic for potential atomic operations (not used directly here)
-#include <vector> // Include vector for dynamic arrays (used for elimination arrays)
-
-// Memory order definitions for atomic operations
-#define SEQCST (memory_order_seq_cst)    // Sequentially consistent
-#define RELAXED (memory_order_relaxed)  // Relaxed memory order
-#define ACQ (memory_order_acquire)      // Acquire memory order
-#define REL (memory_order_release)      // Release memory order
-#define ACQ_REL (memory_order_acq_rel)  // Acquire-release memory order
-
-#define STACK  (1)  // Define a macro for stack buffer type
-#define QUEUE  (2)  // Define a macro for queue buffer type
-
-using namespace std;  // Use the standard namespace
-
-// Performs a compare-and-swap operation on an atomic variable.
-// Compares the variable to an expected value; if they are equal, sets it to a desired value.
-template <typename T>
-bool cas(atomic<T> &status, T expected, T desired, memory_order mem_order);
-
-
-// Define a node structure for the stack or queue
-template <typename T>
-struct node {
-    T element;               // Value stored in the stack/queue node
-    struct node *next;       // Pointer to the next node
-    
-    node(T element, node* next = nullptr) : element(element), next(next) {}
-};
-
-typedef node<int> stack_node;  // Type alias for a stack node holding integer values
-typedef node<int> queue_node;  // Type alias for a queue node holding integer values
-
-// Stack class to implement a basic stack (LIFO: Last In, First Out)
-class stack {
-    public:
-        atomic<bool> lock;           // Atomic lock to prevent race
-        stack_node *top;    // Pointer to the top of the stack
-        
-        stack();            // Constructor to initialize an empty stack
-        void push(int element);     // Push an element onto the stack
-        bool pop(int &element);     // Pop an element from the stack and return its value
-};
-
-// Queue class to implement a basic queue (FIFO: First In, First Out)
-class queue {
-    public:
-        atomic<bool> lock;           // Atomic lock to prevent race
-        queue_node *head;  // Pointer to the head (front) of the queue
-        queue_node *tail;  // Pointer to the tail (rear) of the queue
-        
-        queue();           // Constructor to initialize an empty queue
-        void insert(int element);  // Insert an element at the tail of the queue
-        bool remove(int &element); // Remove an element from the head of the queue and return its value
-};
-
-// Treiber Stack (Lock-Free Stack)
-class treiber_stack {
-    public:
-        atomic<stack_node *> top;  // Atomic pointer to the top of the stack
-
-        treiber_stack();           // Constructor to initialize the Treiber stack
-        void push(int element);    // Push an element onto the Treiber stack
-        bool pop(int &element);    // Pop an element from the Treiber stack and return its value
-};
-
-// MNS Queue (Multi-Node Stack) with atomic operations
-class mns_queue {
-    public:
-        atomic<queue_node *> head; // Atomic pointer to the head (front) of the queue
-        atomic<queue_node *> tail; // Atomic pointer to the tail (rear) of the queue
-        
-        mns_queue();            // Constructor to initialize the MNS queue
-        void insert(int element);  // Insert an element at the tail of the MNS queue
-        bool remove(int &element); // Remove an element from the head of the MNS queue and return its value
-};
-
-// Enumeration to represent different states in the elimination array
-enum states {
-    EMPTY,  // No operation in progress
-    PUSH,   // Push operation in progress
-    POP     // Pop operation in progress
-};
-
-// Struct for an elimination array entry
-struct elimination_array {
-    atomic<int> status;  // Status of the operation (EMPTY, PUSH, POP)
-    int element;         // The element to be pushed or popped
-    
-    elimination_array() : status(EMPTY), element(0) {}  // Constructor initializes status as EMPTY
-};
-
-typedef struct elimination_array elimination_array;  // Typedef for convenience
-
-// Treiber Stack with Elimination
-class treiber_stack_elim {
-    public:
-        atomic<stack_node *> top;     // Atomic pointer to the top of the Treiber stack
-        vector<elimination_array> eli_arr; // Vector of elimination arrays (one for each thread)
-        
-        treiber_stack_elim(int num) : top(nullptr), eli_arr(num) {}  // Constructor initializes top and elimination array
-        
-        void push(int element);        // Push an element onto the Treiber stack with elimination
-        bool pop(int &element);        // Pop an element from the Treiber stack with elimination
-};
-
-// Stack with Elimination (Lock-Free Stack with Elimination)
-class stack_elim {
-    public:
-        atomic<bool> lock;           // Atomic lock to prevent race conditions in push/pop operations
-        atomic<stack_node *> top;    // Atomic pointer to the top of the stack
-        vector<elimination_array> eli_arr; // Vector of elimination arrays (one for each thread)
-        
-        stack_elim(int num) : lock(false), top(nullptr), eli_arr(num) {} // Constructor initializes lock, top, and elimination array
-        
-        void push(int element);       // Push an element onto the stack with elimination
-        bool pop(int &element);       // Pop an element from the stack with elimination
-};
-
-// Stack with Flat Locking
-class stack_flat {
-    public:
-        atomic<bool> lock;           // Atomic lock to prevent race conditions in push/pop operations
-        atomic<stack_node *> top;    // Atomic pointer to the top of the stack
-        vector<elimination_array> eli_arr; // Vector of elimination arrays (one for each thread)
-        
-        stack_flat(int num) : lock(false), top(nullptr), eli_arr(num) {}  // Constructor initializes lock, top, and elimination array
-        
-        void push(int element);       // Push an element onto the stack with flat locking
-        bool pop(int &element);       // Pop an element from the stack with flat locking
-};
+#include <atomic> // Include atomic for potential atomic operations (not used directly here)
+#include <vector> // Include vector for dynamic arrays (used for elimination arrays)
+#include <memory> // unique_ptr payloads
+#include <utility> // forward and move for generic elements
+#include <cstdint> // uintptr_t for tagged pointers
+#include <iterator> // distance for the bulk operations
+#include <algorithm> // min for the bulk operations
+#include <new> // hardware_destructive_interference_size for the padded layout
+#include <chrono> // Timeouts of pop_wait_for
+
+// Memory order definitions for atomic operations
+#define SEQCST (memory_order_seq_cst)    // Sequentially consistent
+#define RELAXED (memory_order_relaxed)  // Relaxed memory order
+#define ACQ (memory_order_acquire)      // Acquire memory order
+#define REL (memory_order_release)      // Release memory order
+#define ACQ_REL (memory_order_acq_rel)  // Acquire-release memory order
+
+#define STACK  (1)  // Define a macro for stack buffer type
+#define QUEUE  (2)  // Define a macro for queue buffer type
+#define PRIORITY (3)  // Priority queue buffer type (--pq)
+
+using namespace std;  // Use the standard namespace
+
+// Performs a compare-and-swap operation on an atomic variable.
+// Compares the variable to an expected value; if they are equal, sets it to a desired value.
+// Defined here (not in buffer.cpp) so the reclamation domains can share it.
+template <typename T>
+bool cas(atomic<T> &status, T expected, T desired, memory_order mem_order) {
+    T expected_ref = expected;
+    return status.compare_exchange_strong(expected_ref, desired, mem_order);
+}
+
+// Hint to the CPU that the thread is spinning
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Layout policy for the hot fields of the containers (heads, tails, tops, locks, elimination slots):
+// padded (default) puts each of them on its own cache line so threads spinning on different fields do not
+// invalidate each other; `make LAYOUT=packed` (-DLAYOUT_PACKED) lets the compiler pack them, for comparison.
+// GCC warns that hardware_destructive_interference_size depends on -mtune, so it is read once here.
+#if defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+constexpr size_t CACHE_LINE_SIZE = hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
+
+#ifdef LAYOUT_PACKED
+#define CACHE_ALIGNED              // Packed: no padding between hot fields
+#define LAYOUT_NAME "packed"
+#else
+#define CACHE_ALIGNED alignas(CACHE_LINE_SIZE)  // Padded: the field starts its own cache line
+#define LAYOUT_NAME "padded"
+#endif
+
+#include "reclamation.hpp"  // Reclamation policies for the lock-free containers (uses the macros above)
+#include "node_pool.hpp"    // Per-thread node pool backing every node allocation
+#include "locks.hpp"        // Lock policies for the lock-based containers (uses the macros above)
+#include "parking.hpp"      // Futex parking behind pop_wait / pop_wait_for (uses the macros above)
+
+
+// Define a node structure for the stack or queue
+// The element is stored inline and constructed in place from whatever push() was given
+template <typename T>
+struct node {
+    T element;               // Value stored in the stack/queue node
+    struct node *next;       // Pointer to the next node
+    
+    template <typename U>
+    node(U &&element, node* next = nullptr) : element(forward<U>(element)), next(next) {}
+
+    // Nodes come from the per-thread pool instead of the global heap
+    static void *operator new(size_t size) { return pool_allocate(size); }
+    static void operator delete(void *ptr, size_t size) { pool_free(ptr, size); }
+};
+
+// Node for the M&S queue: next is linked with CAS by concurrent enqueuers, so it must be atomic
+template <typename T>
+struct atomic_node {
+    T element;                      // Value stored in the queue node
+    atomic<atomic_node *> next;     // Atomic pointer to the next node
+
+    atomic_node() : element(), next(nullptr) {}  // Dummy node
+    template <typename U>
+    atomic_node(U &&element, atomic_node* next = nullptr) : element(forward<U>(element)), next(next) {}
+
+    // Nodes come from the per-thread pool instead of the global heap
+    static void *operator new(size_t size) { return pool_allocate(size); }
+    static void operator delete(void *ptr, size_t size) { pool_free(ptr, size); }
+};
+
+template <typename T> using stack_node = node<T>;        // Node of the stack classes
+template <typename T> using queue_node = node<T>;        // Node of the SGL queue
+template <typename T> using mns_node = atomic_node<T>;   // Node of the M&S queue
+template <typename T> using twolock_node = atomic_node<T>; // Node of the two-lock queue (next is written under the tail lock, read under the head lock)
+template <typename T> using tagged_node = atomic_node<T>; // Node of the tagged Treiber stack (next is read racily)
+
+// Deleter handed to a reclamation policy when a node is retired
+template <typename N>
+void delete_node(void *ptr) {
+    delete static_cast<N *>(ptr);
+}
+
+// Set the successor of a node that is still private to the calling thread
+template <typename T>
+void link_next(node<T> *temp, node<T> *next) { temp->next = next; }
+template <typename T>
+void link_next(atomic_node<T> *temp, atomic_node<T> *next) { temp->next.store(next, RELAXED); }
+
+// Build a private chain for push_bulk on a stack: the last element of [first, last) ends up first,
+// exactly as if each element had been pushed on its own. Returns the top of the chain and its bottom in tail.
+template <typename N, typename It>
+N *make_stack_chain(It first, It last, N *&tail) {
+    N *head = nullptr;
+    tail = nullptr;
+    for (; first != last; ++first) {
+        N *temp = new N(move(*first));
+        link_next(temp, head);
+        if (!head) {
+            tail = temp;
+        }
+        head = temp;
+    }
+    return head;
+}
+
+// Build a private chain for push_bulk on a queue, in insertion order. Returns the first node and the last one in tail.
+template <typename N, typename It>
+N *make_queue_chain(It first, It last, N *&tail) {
+    N *head = nullptr;
+    tail = nullptr;
+    for (; first != last; ++first) {
+        N *temp = new N(move(*first));
+        if (tail) {
+            link_next(tail, temp);
+        } else {
+            head = temp;
+        }
+        tail = temp;
+    }
+    return head;
+}
+
+// 64-byte fixed-size message, the large payload the containers are instantiated for besides int
+struct message {
+    long long words[8];
+};
+
+// All containers are templates over the element type T and are explicitly instantiated in buffer.cpp
+// for int, message and unique_ptr<message>. push()/insert() forward their argument into a freshly
+// allocated node (so a move-only or large element is moved or constructed in place, never boxed) and
+// hand the node to push_node()/insert_node(); pop()/remove() move the element out.
+//
+// Every stack and queue also has push_bulk(first, last) and pop_bulk(out, max). push_bulk moves the
+// elements out of the range into a private chain first and publishes the whole chain at once (one CAS or one lock hold);
+// pop_bulk detaches up to max elements at once, moves them to out[0..n) in pop order and returns n.
+// The bounded queues (ring_queue, spsc_queue) return from push_bulk how many elements fit; the rest of the
+// range is left untouched for the retry.
+//
+// pop_wait(element) and pop_wait_for(element, timeout) are the blocking pops: they go through park_pop below,
+// which sleeps on the container's park_gate. Every successful push calls gate.notify() once the element is
+// visible, which only enters the kernel if a consumer is parked.
+
+// Non-blocking pop of any container, whatever it calls it
+template <typename Buffer, typename T>
+bool park_try_pop(Buffer &buffer, T &element) {
+    if constexpr (requires { buffer.try_pop(element); }) {
+        return buffer.try_pop(element);
+    } else if constexpr (requires { buffer.pop(element); }) {
+        return buffer.pop(element);
+    } else {
+        return buffer.remove(element);
+    }
+}
+
+// Retry the pop PARK_SPIN times, then park on the gate until a push wakes us or timeout_ns runs out (< 0: never).
+// The pop after prepare_wait closes the race with a push that came before the waiting bit was visible.
+template <typename Buffer, typename T>
+bool park_pop(Buffer &buffer, T &element, long long timeout_ns) {
+    for (int i = 0; i < PARK_SPIN; i++) {
+        if (park_try_pop(buffer, element)) {
+            return true;
+        }
+        cpu_relax();
+    }
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::nanoseconds(max(timeout_ns, 0ll));
+    while (true) {
+        unsigned key = buffer.gate.prepare_wait();
+        if (park_try_pop(buffer, element)) {
+            return true;  // A stale waiting bit only costs the next push one wake
+        }
+        long long left = PARK_FOREVER;
+        if (timeout_ns >= 0) {
+            left = chrono::duration_cast<chrono::nanoseconds>(deadline - chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                return false;
+            }
+        }
+        buffer.gate.wait(key, left);
+    }
+}
+
+// Stack class to implement a basic stack (LIFO: Last In, First Out)
+// Lock decides how threads wait for the single global lock (tas_lock, ttas_lock, ticket_lock, mcs_lock, clh_lock)
+template <typename T, typename Lock = mcs_lock>
+class stack {
+    public:
+        Lock lock;                   // Lock to prevent race
+        stack_node<T> *top;    // Pointer to the top of the stack
+        
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        stack();            // Constructor to initialize an empty stack
+        template <typename U>
+        void push(U &&element) { push_node(new stack_node<T>(forward<U>(element))); }  // Push an element onto the stack
+        void push_node(stack_node<T> *temp);  // Link an allocated node on top of the stack
+        bool pop(T &element);     // Pop an element from the stack and return its value
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range of elements with one lock hold
+            stack_node<T> *tail;
+            stack_node<T> *head = make_stack_chain(first, last, tail);
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(stack_node<T> *first, stack_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);  // Pop up to max elements with one lock hold
+};
+
+// Queue class to implement a basic queue (FIFO: First In, First Out)
+template <typename T, typename Lock = mcs_lock>
+class queue {
+    public:
+        Lock lock;                   // Lock to prevent race
+        queue_node<T> *head;  // Pointer to the head (front) of the queue
+        queue_node<T> *tail;  // Pointer to the tail (rear) of the queue
+        
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        queue();           // Constructor to initialize an empty queue
+        template <typename U>
+        void insert(U &&element) { insert_node(new queue_node<T>(forward<U>(element))); }  // Insert an element at the tail of the queue
+        void insert_node(queue_node<T> *temp);  // Link an allocated node at the tail of the queue
+        bool remove(T &element); // Remove an element from the head of the queue and return its value
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements with one lock hold
+            queue_node<T> *tail;
+            queue_node<T> *head = make_queue_chain(first, last, tail);
+            if (head) {
+                insert_chain(head, tail);
+            }
+        }
+        void insert_chain(queue_node<T> *first, queue_node<T> *last);  // Link a private chain at the tail
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max elements with one lock hold
+};
+
+// Treiber Stack (Lock-Free Stack)
+// Reclaimer decides when popped nodes are freed (leak_reclaimer, hazard_pointer_reclaimer, epoch_reclaimer)
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class treiber_stack {
+    public:
+        CACHE_ALIGNED atomic<stack_node<T> *> top;  // Atomic pointer to the top of the stack
+
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        treiber_stack();           // Constructor to initialize the Treiber stack
+        template <typename U>
+        void push(U &&element) { push_node(new stack_node<T>(forward<U>(element))); }  // Push an element onto the Treiber stack
+        void push_node(stack_node<T> *temp);  // Link an allocated node on top of the stack
+        bool pop(T &element);    // Pop an element from the Treiber stack and return its value
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range of elements with one successful CAS
+            stack_node<T> *tail;
+            stack_node<T> *head = make_stack_chain(first, last, tail);
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(stack_node<T> *first, stack_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);  // Detach up to max nodes with one successful CAS
+        size_t drain(vector<T> &out);         // Take the whole stack with one exchange(nullptr), appended to out
+};
+
+// MNS Queue (Multi-Node Stack) with atomic operations
+// Reclaimer decides when dequeued dummy nodes are freed
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class mns_queue {
+    public:
+        CACHE_ALIGNED atomic<mns_node<T> *> head; // Atomic pointer to the head (front) of the queue
+        CACHE_ALIGNED atomic<mns_node<T> *> tail; // Atomic pointer to the tail (rear) of the queue
+        
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        mns_queue();            // Constructor to initialize the MNS queue
+        template <typename U>
+        void insert(U &&element) { insert_node(new mns_node<T>(forward<U>(element))); }  // Insert an element at the tail of the MNS queue
+        void insert_node(mns_node<T> *temp);  // Link an allocated node at the tail of the queue
+        bool remove(T &element); // Remove an element from the head of the MNS queue and return its value
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements with one successful link CAS
+            mns_node<T> *tail;
+            mns_node<T> *head = make_queue_chain(first, last, tail);
+            if (head) {
+                insert_chain(head, tail);
+            }
+        }
+        void insert_chain(mns_node<T> *first, mns_node<T> *last);  // Link a private chain at the tail
+        size_t pop_bulk(T *out, size_t max);  // Move head past up to max nodes with one successful CAS
+};
+
+// Two-lock queue (Michael, Scott 1996): a dummy node separates the two ends, so enqueuers only take the
+// tail lock and dequeuers only the head lock and both ends run in parallel without CAS retries.
+// The locks and the pointers they guard sit on different cache lines in the padded layout.
+template <typename T, typename Lock = mcs_lock>
+class twolock_queue {
+    public:
+        Lock head_lock;                        // Serializes dequeuers
+        twolock_node<T> *head;                 // Dummy node, its successor holds the front element
+        Lock tail_lock;                        // Serializes enqueuers
+        CACHE_ALIGNED twolock_node<T> *tail;   // Last node of the queue
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        twolock_queue();           // Constructor creates the dummy node
+        template <typename U>
+        void insert(U &&element) { insert_node(new twolock_node<T>(forward<U>(element))); }  // Insert an element at the tail
+        void insert_node(twolock_node<T> *temp);  // Link an allocated node at the tail (tail lock only)
+        bool remove(T &element);   // Remove the front element (head lock only)
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements with one tail lock hold
+            twolock_node<T> *tail;
+            twolock_node<T> *head = make_queue_chain(first, last, tail);
+            if (head) {
+                insert_chain(head, tail);
+            }
+        }
+        void insert_chain(twolock_node<T> *first, twolock_node<T> *last);  // Link a private chain at the tail
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max elements with one head lock hold
+};
+
+// Cell of the ring queue: sequence says whose turn it is (pos: free for the enqueuer at pos,
+// pos + 1: full for the dequeuer at pos, pos + capacity: free again for the next lap)
+template <typename T>
+struct ring_cell {
+    atomic<size_t> sequence;  // Turn counter of the cell
+    T element;                // Element stored in the cell (moved in and out)
+
+    ring_cell() : sequence(0), element() {}
+};
+
+// Bounded MPMC ring queue (Vyukov): a power-of-two array of cells with a sequence number each.
+// Producers and consumers claim positions with a CAS on their own counter and never touch a node allocator,
+// so a full queue pushes back on the producer (try_push returns false) instead of growing.
+template <typename T>
+class ring_queue {
+    public:
+        vector<ring_cell<T>> cells;             // Ring storage, capacity rounded up to a power of two
+        size_t mask;                            // capacity - 1
+        CACHE_ALIGNED atomic<size_t> enqueue_pos; // Next position to enqueue (own cache line)
+        CACHE_ALIGNED atomic<size_t> dequeue_pos; // Next position to dequeue (own cache line)
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        ring_queue(size_t capacity);  // Constructor allocates the ring
+        template <typename U>
+        bool try_push(U &&element) {  // Insert an element unless the queue is full
+            size_t pos;
+            ring_cell<T> *cell = claim_push(pos);
+            if (!cell) {
+                return false;  // Full
+            }
+            cell->element = forward<U>(element);
+            cell->sequence.store(pos + 1, REL);  // Hand the cell to the dequeuer of pos
+            gate.notify();
+            return true;
+        }
+        bool try_pop(T &element);      // Remove the element at the head unless the queue is empty
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        ring_cell<T> *claim_push(size_t &pos);  // Claim the cell at the enqueue position, nullptr when full
+
+        template <typename It>
+        size_t push_bulk(It first, It last) {  // Insert as many elements of the range as fit, claiming them with one CAS
+            size_t pos;
+            size_t count = claim_push_bulk(pos, distance(first, last));
+            for (size_t i = 0; i < count; i++, ++first) {
+                ring_cell<T> &cell = cells[(pos + i) & mask];
+                cell.element = move(*first);
+                cell.sequence.store(pos + i + 1, REL);  // Hand the cell to the dequeuer of pos + i
+            }
+            if (count) {
+                gate.notify();
+            }
+            return count;
+        }
+        size_t claim_push_bulk(size_t &pos, size_t max);  // Claim up to max consecutive free cells starting at pos
+        size_t pop_bulk(T *out, size_t max);              // Remove up to max elements, claiming them with one CAS
+
+        template <typename U>
+        void insert(U &&element) { while (!try_push(forward<U>(element))); }  // Blocking insert: spin while full
+        bool remove(T &element) { return try_pop(element); }                  // Same as try_pop
+        size_t capacity() const { return mask + 1; }
+};
+
+// Single-producer/single-consumer ring queue (Lamport ring with cached indices).
+// Each side owns one cache line holding its index and a private copy of the other side's index;
+// the shared index is only re-read when the cached copy says the ring is full (producer) or empty (consumer).
+// Exactly one thread may call try_push and exactly one (possibly other) thread try_pop.
+template <typename T>
+class spsc_queue {
+    public:
+        CACHE_ALIGNED vector<T> cells;   // Ring storage, capacity rounded up to a power of two (read-only after construction)
+        size_t mask;                   // capacity - 1
+        CACHE_ALIGNED atomic<size_t> head;  // Next position to pop, written by the consumer
+        size_t cached_tail;               // Consumer's copy of tail
+        CACHE_ALIGNED atomic<size_t> tail;  // Next position to push, written by the producer
+        size_t cached_head;               // Producer's copy of head
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        spsc_queue(size_t capacity);   // Constructor allocates the ring
+        template <typename U>
+        bool try_push(U &&element) {   // Producer: insert an element unless the ring is full
+            size_t pos = tail.load(RELAXED);
+            if (pos - cached_head > mask) {
+                cached_head = head.load(ACQ);  // Looks full, refresh the consumer's index
+                if (pos - cached_head > mask) {
+                    return false;
+                }
+            }
+            cells[pos & mask] = forward<U>(element);
+            tail.store(pos + 1, REL);  // Publish the element to the consumer
+            gate.notify();
+            return true;
+        }
+        bool try_pop(T &element);      // Consumer: remove the oldest element unless the ring is empty
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        size_t push_bulk(It first, It last) {  // Producer: insert as many elements as fit with one index update
+            size_t pos = tail.load(RELAXED);
+            size_t count = distance(first, last);
+            if (count > capacity() - (pos - cached_head)) {
+                cached_head = head.load(ACQ);
+                count = min(count, capacity() - (pos - cached_head));
+            }
+            for (size_t i = 0; i < count; i++, ++first) {
+                cells[(pos + i) & mask] = move(*first);
+            }
+            tail.store(pos + count, REL);  // Publish the whole batch to the consumer
+            if (count) {
+                gate.notify();
+            }
+            return count;
+        }
+        size_t pop_bulk(T *out, size_t max);  // Consumer: remove up to max elements with one index update
+        size_t capacity() const { return mask + 1; }
+};
+
+// State of a cell of the fetch-and-add queue
+enum cell_states {
+    CELL_EMPTY,  // No enqueuer has written the cell yet
+    CELL_FULL,   // Holds an element for the dequeuer that claimed its index
+    CELL_TAKEN   // Consumed, or skipped by a dequeuer that overtook the enqueuer
+};
+
+#define FAA_SEGMENT_SIZE (1024)  // Cells per segment of the fetch-and-add queue
+
+// Cell of a fetch-and-add queue segment
+template <typename T>
+struct faa_cell {
+    atomic<int> state;  // CELL_EMPTY, CELL_FULL or CELL_TAKEN
+    T element;          // Element written by the enqueuer that claimed the cell
+
+    faa_cell() : state(CELL_EMPTY), element() {}
+};
+
+// Segment of the fetch-and-add queue: an array of cells handed out by two fetch_add counters
+template <typename T>
+struct faa_segment {
+    CACHE_ALIGNED atomic<unsigned> enq_idx;  // Next cell to hand to an enqueuer
+    CACHE_ALIGNED atomic<unsigned> deq_idx;  // Next cell to hand to a dequeuer
+    atomic<faa_segment *> next;            // Segment appended once this one is exhausted
+    faa_cell<T> cells[FAA_SEGMENT_SIZE];
+
+    faa_segment() : enq_idx(0), deq_idx(0), next(nullptr) {}
+};
+
+// Unbounded fetch-and-add queue: a linked list of array segments (segment-of-rings, after LCRQ and
+// FAAArrayQueue). Enqueuers and dequeuers claim a cell with one fetch_add instead of retrying a CAS
+// on head/tail; only the move to a new segment uses M&S-style CAS linking.
+// Reclaimer decides when drained segments are freed
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class faa_queue {
+    public:
+        CACHE_ALIGNED atomic<faa_segment<T> *> head;  // Segment dequeuers work on
+        CACHE_ALIGNED atomic<faa_segment<T> *> tail;  // Segment enqueuers work on
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        faa_queue();            // Constructor allocates the first segment
+        template <typename U>
+        void insert(U &&element) {  // Insert an element at the tail of the queue
+            T temp(forward<U>(element));
+            insert_element(temp);
+        }
+        void insert_element(T &element);  // Move an element into the next free cell
+        bool remove(T &element);          // Remove an element from the head of the queue
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements, claiming their cells with one fetch_add
+            static thread_local vector<T> temp;  // Reused across calls: no allocation per batch
+            temp.assign(make_move_iterator(first), make_move_iterator(last));
+            insert_bulk(temp.data(), temp.size());
+        }
+        void insert_bulk(T *elements, size_t count);  // Move count elements into consecutive cells
+        size_t pop_bulk(T *out, size_t max);          // Remove up to max elements, claiming their cells with one fetch_add
+};
+
+// Tagged pointers: a {pointer, version} pair updated as one unit so a node that is popped and pushed
+// again between a load and a CAS (ABA) makes the CAS fail. With cmpxchg16b (-mcx16 on x86-64) the pair
+// is two full words; otherwise the version is packed into the unused upper 16 bits of the pointer.
+#if defined(__x86_64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define TAGGED_DWCAS (1)  // 128-bit compare-and-swap
+#else
+#define TAGGED_DWCAS (0)  // 48-bit pointer + 16-bit version in one word
+#endif
+#define TAGGED_PTR_BITS (48)  // Significant bits of a user-space pointer in the packed layout
+
+template <typename N>
+struct tagged_ptr {
+    N *ptr;          // Node pointer
+    uintptr_t tag;   // Version, incremented by every successful update
+};
+
+template <typename N>
+class atomic_tagged_ptr {
+    private:
+#if TAGGED_DWCAS
+        alignas(16) uintptr_t word[2];  // word[0] = pointer, word[1] = version (low and high half on x86-64)
+#else
+        atomic<uintptr_t> word;         // Version in the upper 16 bits, pointer in the lower 48
+#endif
+
+    public:
+        atomic_tagged_ptr() {
+#if TAGGED_DWCAS
+            word[0] = word[1] = 0;
+#else
+            word.store(0, RELAXED);
+#endif
+        }
+
+        // The two halves are read separately; a torn pair only makes the following CAS fail
+        tagged_ptr<N> load() const {
+#if TAGGED_DWCAS
+            uintptr_t tag = __atomic_load_n(&word[1], __ATOMIC_ACQUIRE);
+            uintptr_t ptr = __atomic_load_n(&word[0], __ATOMIC_ACQUIRE);
+            return {reinterpret_cast<N *>(ptr), tag};
+#else
+            uintptr_t packed = word.load(ACQ);
+            return {reinterpret_cast<N *>(packed & ((uintptr_t(1) << TAGGED_PTR_BITS) - 1)), packed >> TAGGED_PTR_BITS};
+#endif
+        }
+
+        // Install desired with version expected.tag + 1 if the pair still equals expected
+        bool compare_exchange(tagged_ptr<N> expected, N *desired) {
+#if TAGGED_DWCAS
+            unsigned __int128 old_pair = ((unsigned __int128)expected.tag << 64) | reinterpret_cast<uintptr_t>(expected.ptr);
+            unsigned __int128 new_pair = ((unsigned __int128)(expected.tag + 1) << 64) | reinterpret_cast<uintptr_t>(desired);
+            return __sync_bool_compare_and_swap(reinterpret_cast<unsigned __int128 *>(word), old_pair, new_pair);
+#else
+            uintptr_t old_pair = (expected.tag << TAGGED_PTR_BITS) | reinterpret_cast<uintptr_t>(expected.ptr);
+            uintptr_t new_pair = ((expected.tag + 1) << TAGGED_PTR_BITS) | reinterpret_cast<uintptr_t>(desired);
+            return cas(word, old_pair, new_pair, ACQ_REL);
+#endif
+        }
+};
+
+// Treiber Stack with a tagged top (ABA-safe)
+// Popped nodes are never freed: they go to a tagged free list and are reused by later pushes,
+// so reading next of a node that was popped concurrently is always safe and the tag catches the reuse.
+template <typename T>
+class treiber_stack_tagged {
+    public:
+        CACHE_ALIGNED atomic_tagged_ptr<tagged_node<T>> top;        // {top node, version}
+        atomic_tagged_ptr<tagged_node<T>> free_list;  // {first recycled node, version}
+
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        treiber_stack_tagged() {}  // Both start empty
+        template <typename U>
+        void push(U &&element) {   // Push an element onto the stack, reusing a recycled node if there is one
+            tagged_node<T> *temp = acquire_node();
+            temp->element = forward<U>(element);
+            push_node(temp);
+        }
+        void push_node(tagged_node<T> *temp);  // Link a node on top of the stack
+        bool pop(T &element);                  // Pop an element and recycle its node
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {    // Push a range of elements with one successful CAS
+            tagged_node<T> *head = nullptr;
+            tagged_node<T> *tail = nullptr;
+            for (; first != last; ++first) {
+                tagged_node<T> *temp = acquire_node();
+                temp->element = move(*first);
+                temp->next.store(head, RELAXED);
+                if (!head) {
+                    tail = temp;
+                }
+                head = temp;
+            }
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(tagged_node<T> *first, tagged_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);   // Detach up to max nodes with one successful CAS
+        tagged_node<T> *acquire_node();        // Take a node from the free list or allocate one
+        void recycle_node(tagged_node<T> *temp);  // Put a popped node on the free list
+        void recycle_chain(tagged_node<T> *first, tagged_node<T> *last);  // Put a chain of popped nodes on the free list
+};
+
+// Enumeration to represent different states in the elimination array
+enum states {
+    EMPTY,  // No operation in progress
+    PUSH,   // Push operation in progress
+    POP,    // Pop operation in progress
+    BUSY    // A popper is moving the element out of the slot
+};
+
+// State word of an elimination slot: the low ELIM_STATUS_BITS hold the status (EMPTY, PUSH, POP, BUSY), the
+// bits above it a tag that every claim of the slot increments. A pusher withdraws its offer with a CAS on the
+// whole word, so it cannot succeed on a later offer another pusher published in the same slot (ABA).
+#define ELIM_STATUS_BITS (2)
+#define ELIM_STATUS_MASK ((1ull << ELIM_STATUS_BITS) - 1)
+#define ELIM_TAG_ONE     (1ull << ELIM_STATUS_BITS)  // Tag increment
+
+// Struct for an elimination array entry, one cache line per slot in the padded layout so threads
+// waiting on different slots do not share a line
+// The element is moved into and out of the slot, so T must be default constructible
+template <typename T>
+struct CACHE_ALIGNED elimination_array {
+    atomic<unsigned long long> state;  // (tag << ELIM_STATUS_BITS) | status
+    T element;           // The element to be pushed or popped
+    
+    elimination_array() : state(EMPTY), element() {}  // Constructor initializes status as EMPTY
+};
+
+#define ELIM_MAX_WIDTH (32)    // Slots in the elimination arrays of the drivers (the active range adapts below this)
+#define ELIM_SPIN_MIN  (16)    // Shortest wait of an elimination offer, in pause iterations
+#define ELIM_SPIN_MAX  (4096)  // Longest wait of an elimination offer, in pause iterations
+
+// Elimination counters, summed over all threads that have exited plus the calling thread
+struct elim_stats {
+    unsigned long long attempts;  // Pushes and pops that tried the elimination array
+    unsigned long long hits;      // Of those, operations completed by meeting a partner
+    unsigned long long young;     // Queue offers a dequeue left alone because older elements were still queued
+};
+
+elim_stats elim_get_stats();  // Read the elimination counters
+
+// Contention counters (`make STATS=on`, -DCONTENTION_STATS): plain per-thread tallies of what the containers
+// retry on, kept in a thread_local (no shared writes) and added to global totals when the thread exits.
+// Without the flag the CONTENTION_* macros expand to nothing and CONTENTION_CAS to its bare condition.
+#ifdef CONTENTION_STATS
+#define CONTENTION_PUSH (0)  // Counter index of push / insert / try_push
+#define CONTENTION_POP  (1)  // Counter index of pop / remove / try_pop / delete_min / steal
+#define CONTENTION_OPS  (2)
+
+struct contention_stats {
+    unsigned long long cas_attempts[CONTENTION_OPS];  // CASes (and exchanges that can lose) on the containers' shared words
+    unsigned long long cas_failures[CONTENTION_OPS];  // Of those, the ones another thread won
+    unsigned long long lock_acquires;                 // Lock acquisitions of the lock-based containers
+    unsigned long long lock_spins;                    // Polls of a lock held by another thread
+    unsigned long long elim_attempts[ELIM_MAX_WIDTH]; // Elimination tries, per slot
+    unsigned long long elim_hits[ELIM_MAX_WIDTH];     // Of those, operations that met a partner
+    unsigned long long elim_timeouts[ELIM_MAX_WIDTH]; // Push offers withdrawn because nobody took them in time
+    unsigned long long combiner_sessions;             // Lock holds of a flat combiner
+    unsigned long long combiner_passes;               // Passes over the publication list that served something
+    unsigned long long combined_ops;                  // Requests served by those passes
+    unsigned long long max_batch;                     // Most requests served by one pass
+    unsigned long long empty_pops;                    // Pops that returned without an element
+};
+
+struct contention_thread_state {
+    contention_stats local = {};  // Counters not yet added to the totals
+
+    ~contention_thread_state();
+};
+
+extern thread_local contention_thread_state contention_local;
+
+inline bool contention_cas(int op, bool success) {
+    contention_local.local.cas_attempts[op]++;
+    contention_local.local.cas_failures[op] += !success;
+    return success;
+}
+
+#define CONTENTION_CAS(op, success) contention_cas(CONTENTION_##op, (success))
+#define CONTENTION_COUNT(field) (contention_local.local.field++)
+#define CONTENTION_SLOT(field, slot) (contention_local.local.field[(slot) % ELIM_MAX_WIDTH]++)
+#define CONTENTION_BATCH(count) (contention_local.local.combiner_passes++, contention_local.local.combined_ops += (count), \
+                                 contention_local.local.max_batch = max(contention_local.local.max_batch, (unsigned long long)(count)))
+
+contention_stats contention_get_stats();  // Read the contention counters
+#else
+#define CONTENTION_CAS(op, success) (success)
+#define CONTENTION_COUNT(field) ((void)0)
+#define CONTENTION_SLOT(field, slot) ((void)0)
+#define CONTENTION_BATCH(count) ((void)0)
+#endif
+
+// Treiber Stack with Elimination
+// Reclaimer decides when popped nodes are freed
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class treiber_stack_elim {
+    public:
+        CACHE_ALIGNED atomic<stack_node<T> *> top;     // Atomic pointer to the top of the Treiber stack
+        vector<elimination_array<T>> eli_arr; // Vector of elimination arrays (one for each thread)
+        
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        treiber_stack_elim(int num) : top(nullptr), eli_arr(num) {}  // Constructor initializes top and elimination array
+        
+        template <typename U>
+        void push(U &&element) { push_node(new stack_node<T>(forward<U>(element))); }  // Push an element onto the Treiber stack with elimination
+        void push_node(stack_node<T> *temp);  // Push an allocated node, or hand its element to a pop
+        bool pop(T &element);        // Pop an element from the Treiber stack with elimination
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range of elements with one successful CAS (no elimination)
+            stack_node<T> *tail;
+            stack_node<T> *head = make_stack_chain(first, last, tail);
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(stack_node<T> *first, stack_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);  // Detach up to max nodes with one successful CAS
+        size_t drain(vector<T> &out);         // Take the whole stack with one exchange(nullptr), appended to out
+};
+
+// Stack with Elimination (Lock-Free Stack with Elimination)
+template <typename T, typename Lock = mcs_lock>
+class stack_elim {
+    public:
+        Lock lock;                   // Lock to prevent race conditions in push/pop operations
+        CACHE_ALIGNED atomic<stack_node<T> *> top;    // Atomic pointer to the top of the stack
+        vector<elimination_array<T>> eli_arr; // Vector of elimination arrays (one for each thread)
+        
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        stack_elim(int num) : top(nullptr), eli_arr(num) {} // Constructor initializes lock, top, and elimination array
+        
+        template <typename U>
+        void push(U &&element) { push_node(new stack_node<T>(forward<U>(element))); }  // Push an element onto the stack with elimination
+        void push_node(stack_node<T> *temp);  // Push an allocated node, or hand its element to a pop
+        bool pop(T &element);       // Pop an element from the stack with elimination
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range of elements with one lock hold
+            stack_node<T> *tail;
+            stack_node<T> *head = make_stack_chain(first, last, tail);
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(stack_node<T> *first, stack_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);  // Pop up to max elements with one lock hold
+};
+
+// Node of the elimination-backed M&S queue: seq is its position in the queue (predecessor's seq + 1),
+// set by the enqueuer before the node is linked and never changed afterwards
+template <typename T>
+struct seq_node {
+    T element;                   // Value stored in the queue node
+    atomic<seq_node *> next;     // Atomic pointer to the next node
+    unsigned long long seq;      // Position in the queue (the initial dummy is 0)
+
+    seq_node() : element(), next(nullptr), seq(0) {}  // Dummy node
+    template <typename U>
+    seq_node(U &&element) : element(forward<U>(element)), next(nullptr), seq(0) {}
+
+    // Nodes come from the per-thread pool instead of the global heap
+    static void *operator new(size_t size) { return pool_allocate(size); }
+    static void operator delete(void *ptr, size_t size) { pool_free(ptr, size); }
+};
+
+template <typename T>
+void link_next(seq_node<T> *temp, seq_node<T> *next) { temp->next.store(next, RELAXED); }
+
+// Elimination slot of the queue: the state word holds the status and claim tag of elimination_array, and
+// above them the seq of the tail the offering enqueuer last saw, so a dequeue checks and claims the offer
+// with one CAS on the same word. The seq alone is no tag: two enqueuers can offer the same seq in turn.
+#define ELIM_TAG_BITS  (16)                                      // Tag bits of a queue slot (wraps, seq above)
+#define ELIM_TAG_MASK  (((1ull << ELIM_TAG_BITS) - 1) << ELIM_STATUS_BITS)
+#define ELIM_SEQ_SHIFT (ELIM_STATUS_BITS + ELIM_TAG_BITS)
+
+template <typename T>
+struct CACHE_ALIGNED queue_elim_slot {
+    atomic<unsigned long long> state;  // (seq << ELIM_SEQ_SHIFT) | (tag << ELIM_STATUS_BITS) | status
+    T element;                         // Offered element
+
+    queue_elim_slot() : state(EMPTY), element() {}
+};
+
+// M&S queue with elimination (Moir, Nussbaum, Shalev, Shavit 2005)
+// An enqueue that loses the CAS on the tail offers its element in the elimination array, tagged with the
+// seq of the tail it saw. A dequeue that finds the queue empty may take an offer only if it is old enough:
+// the dummy it saw has a seq no smaller than the offer's, so every element enqueued before the offer has
+// been dequeued and handing it over directly is the same as enqueueing and dequeueing it right there.
+// Everything else runs the normal M&S path. Reclaimer decides when dequeued dummy nodes are freed.
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class mns_elim_queue {
+    public:
+        CACHE_ALIGNED atomic<seq_node<T> *> head;           // Atomic pointer to the head (dummy) of the queue
+        CACHE_ALIGNED atomic<seq_node<T> *> tail;           // Atomic pointer to the tail (rear) of the queue
+        vector<queue_elim_slot<T>> eli_arr;   // Elimination slots shared by enqueuers and dequeuers
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        mns_elim_queue(int num);  // Constructor creates the dummy node and num elimination slots
+        template <typename U>
+        void insert(U &&element) { insert_node(new seq_node<T>(forward<U>(element))); }  // Insert an element, or hand it to a dequeue
+        void insert_node(seq_node<T> *temp);  // Link an allocated node at the tail, or hand its element to a dequeue
+        bool remove(T &element);  // Remove the element at the head, or take an old enough offer if the queue is empty
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements with one successful link CAS (no elimination)
+            seq_node<T> *tail;
+            seq_node<T> *head = make_queue_chain(first, last, tail);
+            if (head) {
+                insert_chain(head, tail);
+            }
+        }
+        void insert_chain(seq_node<T> *first, seq_node<T> *last);  // Number a private chain and link it at the tail
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max elements one at a time
+};
+
+
+// State of a reservation in the dual containers
+enum dual_states {
+    DUAL_WAITING,    // The pop that left the reservation is spinning on it
+    DUAL_CLAIMED,    // A push won the reservation and is moving its element in
+    DUAL_FULFILLED,  // The element is in the node, the pop may take it
+    DUAL_CANCELLED   // The pop gave up; pushes unlink the node and look further
+};
+
+#define DUAL_POP_WAIT (50000)       // How long pop()/remove() wait on their reservation before cancelling it, in ns
+#define DUAL_YIELD_INTERVAL (128)   // Polls of a reservation between yields (the fulfilling push may need the CPU)
+#define DUAL_CLOCK_INTERVAL (64)    // Polls of a reservation between reads of the clock
+
+// Node of the dual stack and dual queue: either data or a reservation left by a pop that found the container
+// empty. A push fulfills a reservation by claiming it with one CAS on state and moving its element in.
+template <typename T>
+struct dual_node {
+    T element;                   // Pushed element, or the element handed to a reservation
+    atomic<dual_node *> next;    // Next node (below on the stack, behind in the queue)
+    bool request;                // Reservation rather than data, fixed at construction
+    atomic<int> state;           // Reservations only: DUAL_WAITING .. DUAL_CANCELLED
+    atomic<int> holders;         // Releases left before the node is retired: 2 for a reservation with a waiting pop
+
+    dual_node() : element(), next(nullptr), request(true), state(DUAL_WAITING), holders(1) {}  // Reservation (or the queue's first dummy)
+    template <typename U>
+    dual_node(U &&element) : element(forward<U>(element)), next(nullptr), request(false), state(DUAL_FULFILLED), holders(1) {}
+
+    // Nodes come from the per-thread pool instead of the global heap
+    static void *operator new(size_t size) { return pool_allocate(size); }
+    static void operator delete(void *ptr, size_t size) { pool_free(ptr, size); }
+};
+
+// Dual stack (Scherer, Scott 2004): a pop that finds the stack empty pushes a reservation and spins on that node
+// only, until a push hands it an element; a push that finds a live reservation on top fulfills it instead of
+// pushing. The stack holds either data or reservations; cancelled and fulfilled reservations are unlinked by
+// whoever finds them on top. Reclaimer decides when unlinked nodes are freed.
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class dual_stack {
+    public:
+        CACHE_ALIGNED atomic<dual_node<T> *> top;  // Top data node or reservation
+        park_gate gate;                    // Parks pop_wait callers while their reservation is waiting
+
+        dual_stack() : top(nullptr) {}
+        template <typename U>
+        void push(U &&element) { push_node(new dual_node<T>(forward<U>(element))); }  // Push an element, or hand it to a waiting pop
+        void push_node(dual_node<T> *temp);  // Link a data node, or fulfill the reservation on top with its element
+        bool pop(T &element) { return take(element, true, DUAL_POP_WAIT); }  // Pop, waiting up to DUAL_POP_WAIT ns on a reservation
+        void pop_wait(T &element) { take(element, true, PARK_FOREVER); }    // Pop, parking on a reservation until it is fulfilled
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return take(element, true, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // One element at a time: each may fulfill a different reservation
+            for (; first != last; ++first) {
+                push(move(*first));
+            }
+        }
+        size_t pop_bulk(T *out, size_t max);  // Pop up to max data elements, never leaving a reservation
+        bool take(T &element, bool reserve, long long timeout_ns);  // Pop data, or reserve and wait up to timeout_ns (< 0: no limit)
+};
+
+// Dual queue (Scherer, Scott 2004): the M&S queue with reservation nodes. A remove that finds the queue empty
+// (or holding reservations) appends a reservation and spins on it; an insert that finds reservations fulfills
+// the oldest live one and moves head past it, so waiting consumers are served in FIFO order.
+// Reclaimer decides when dequeued dummy nodes are freed.
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class dual_queue {
+    public:
+        CACHE_ALIGNED atomic<dual_node<T> *> head;  // Dummy node, its successor is the front data node or reservation
+        CACHE_ALIGNED atomic<dual_node<T> *> tail;  // Last node
+        park_gate gate;                    // Parks pop_wait callers while their reservation is waiting
+
+        dual_queue();             // Constructor creates the dummy node
+        template <typename U>
+        void insert(U &&element) { insert_node(new dual_node<T>(forward<U>(element))); }  // Insert an element, or hand it to the oldest waiting remove
+        void insert_node(dual_node<T> *temp);  // Link a data node, or fulfill the front reservation with its element
+        bool remove(T &element) { return take(element, true, DUAL_POP_WAIT); }  // Remove, waiting up to DUAL_POP_WAIT ns on a reservation
+        void pop_wait(T &element) { take(element, true, PARK_FOREVER); }       // Remove, parking on a reservation until it is fulfilled
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return take(element, true, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // One element at a time: each may fulfill a different reservation
+            for (; first != last; ++first) {
+                insert(move(*first));
+            }
+        }
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max data elements, never leaving a reservation
+        bool take(T &element, bool reserve, long long timeout_ns);  // Remove data, or reserve and wait up to timeout_ns (< 0: no limit)
+};
+
+// Element of a MultiStack/MultiQueue shard: the element plus its push ticket for the rank-error measurement
+template <typename T>
+struct multi_item {
+    T element;                // Pushed element
+    unsigned long long seq;   // Push ticket (0 when the rank error is not measured)
+
+    multi_item() : element(), seq(0) {}
+    template <typename U>
+    multi_item(U &&element, unsigned long long seq) : element(forward<U>(element)), seq(seq) {}
+};
+
+// One shard: a container plus its approximate size, each on its own cache line
+template <typename Shard>
+struct multi_shard {
+    Shard buffer;                            // Existing stack or queue holding this shard's elements
+    CACHE_ALIGNED atomic<long long> size;    // Pushes minus pops, read by the two-choice picks
+
+    multi_shard() : size(0) {}
+};
+
+// Event of the rank-error log: a push (ticket == seq) or a pop of the element pushed with ticket seq
+struct rank_event {
+    unsigned long long ticket;  // Position on the container's logical clock
+    unsigned long long seq;     // Push ticket of the element
+};
+
+// How far a relaxed container drifted from strict LIFO/FIFO order
+struct rank_error_stats {
+    unsigned long long pops;   // Pops measured
+    double mean;               // Mean rank error: elements a strict container would have returned first
+    unsigned long long max;    // Largest rank error of a single pop
+};
+
+// Optional rank-error log of a relaxed container. Pushes and pops take tickets from one shared clock, so
+// measuring serializes the threads on it and is meant for quality runs only (--rank), not throughput runs.
+class rank_log {
+    public:
+        bool enabled;                          // Record events at all
+        CACHE_ALIGNED atomic<unsigned long long> clock;  // Logical clock, starts at 1 (0 marks unmeasured elements)
+        vector<vector<rank_event>> events;     // One log per thread index (fc_thread_index)
+
+        rank_log(bool enabled) : enabled(enabled), clock(1), events(enabled ? MAX_THREADS : 0) {}
+        unsigned long long push_ticket() { return enabled ? clock.fetch_add(1, ACQ_REL) : 0; }  // Stamp an element before its push
+        void record_push(unsigned long long seq);  // Log the push of an element stamped seq
+        void record_pop(unsigned long long seq);   // Log a pop of the element stamped seq, after it succeeded
+        rank_error_stats compute(bool lifo);       // Replay the log in clock order (after the threads have joined)
+};
+
+// Relaxed k-sharded stack: shards Treiber stacks. A push goes to the smaller and a pop to the larger of two
+// randomly chosen shards (power of two choices), so the shards stay balanced and each operation touches one
+// top only; LIFO order only holds approximately. A pop that finds both choices empty scans every shard.
+template <typename T>
+class multi_stack {
+    public:
+        vector<multi_shard<treiber_stack<multi_item<T>>>> shards;  // The shards
+        rank_log ranks;                  // Rank-error log (--rank)
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+
+        multi_stack(size_t num_shards, bool measure = false) : shards(max(num_shards, (size_t)1)), ranks(measure) {}
+        template <typename U>
+        void push(U &&element) {  // Push onto the smaller of two random shards
+            unsigned long long seq = ranks.push_ticket();
+            multi_shard<treiber_stack<multi_item<T>>> &shard = shards[pick_push()];
+            shard.buffer.push(multi_item<T>(forward<U>(element), seq));
+            shard.size.fetch_add(1, RELAXED);
+            if (seq) {
+                ranks.record_push(seq);
+            }
+            gate.notify();
+        }
+        bool pop(T &element);      // Pop from the larger of two random shards
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range onto one shard with one successful CAS
+            static thread_local vector<multi_item<T>> items;  // Reused across calls: no allocation per batch
+            items.clear();
+            for (; first != last; ++first) {
+                items.emplace_back(move(*first), ranks.push_ticket());
+            }
+            multi_shard<treiber_stack<multi_item<T>>> &shard = shards[pick_push()];
+            shard.buffer.push_bulk(items.begin(), items.end());
+            shard.size.fetch_add(items.size(), RELAXED);
+            for (size_t i = 0; ranks.enabled && i < items.size(); i++) {
+                ranks.record_push(items[i].seq);
+            }
+            gate.notify();
+        }
+        size_t pop_bulk(T *out, size_t max);  // Pop up to max elements from one shard
+        size_t pick_push();                   // Index of the smaller of two random shards
+        size_t pick_pop();                    // Index of the larger of two random shards
+        rank_error_stats rank_error() { return ranks.compute(true); }  // Rank error against strict LIFO
+};
+
+// Relaxed k-sharded queue: shards M&S queues, picked like the shards of multi_stack; FIFO order only holds
+// approximately, since the balanced shards advance at about the same rate
+template <typename T>
+class multi_queue {
+    public:
+        vector<multi_shard<mns_queue<multi_item<T>>>> shards;  // The shards
+        rank_log ranks;                  // Rank-error log (--rank)
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+
+        multi_queue(size_t num_shards, bool measure = false) : shards(max(num_shards, (size_t)1)), ranks(measure) {}
+        template <typename U>
+        void insert(U &&element) {  // Insert into the smaller of two random shards
+            unsigned long long seq = ranks.push_ticket();
+            multi_shard<mns_queue<multi_item<T>>> &shard = shards[pick_push()];
+            shard.buffer.insert(multi_item<T>(forward<U>(element), seq));
+            shard.size.fetch_add(1, RELAXED);
+            if (seq) {
+                ranks.record_push(seq);
+            }
+            gate.notify();
+        }
+        bool remove(T &element);   // Remove from the larger of two random shards
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Remove, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range into one shard with one successful link CAS
+            static thread_local vector<multi_item<T>> items;  // Reused across calls: no allocation per batch
+            items.clear();
+            for (; first != last; ++first) {
+                items.emplace_back(move(*first), ranks.push_ticket());
+            }
+            multi_shard<mns_queue<multi_item<T>>> &shard = shards[pick_push()];
+            shard.buffer.push_bulk(items.begin(), items.end());
+            shard.size.fetch_add(items.size(), RELAXED);
+            for (size_t i = 0; ranks.enabled && i < items.size(); i++) {
+                ranks.record_push(items[i].seq);
+            }
+            gate.notify();
+        }
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max elements from one shard
+        size_t pick_push();                   // Index of the smaller of two random shards
+        size_t pick_pop();                    // Index of the larger of two random shards
+        rank_error_stats rank_error() { return ranks.compute(false); }  // Rank error against strict FIFO
+};
+
+// Work-stealing deque (Chase, Lev 2005, with the C11 orderings of Le, Pop, Cohen, Zappa Nardelli 2013).
+// One owner pushes and pops at the bottom (LIFO) without a CAS except on the last element; thieves steal
+// from the top (FIFO) with one CAS on top. The ring grows by doubling when the owner finds it full.
+// A thief copies the element out of the ring before its CAS decides whether it won it, so T must be
+// trivially copyable (instantiated for int and message only).
+#define WS_INITIAL_CAPACITY (64)  // Slots of a fresh deque's ring (a power of two)
+#define WS_YIELD_INTERVAL (64)    // Failed steals between yields of a thread that ran out of work
+
+// Ring of a work-stealing deque; a grown deque keeps its old rings until it is destroyed, since a slow
+// thief may still be reading one
+template <typename T>
+struct ws_ring {
+    size_t mask;        // capacity - 1
+    vector<T> slots;    // Element at position i lives in slots[i & mask]
+
+    ws_ring(size_t capacity) : mask(capacity - 1), slots(capacity) {}
+    T &at(long long i) { return slots[i & mask]; }
+    size_t capacity() const { return mask + 1; }
+};
+
+// Work-stealing counters, summed over all threads that have exited plus the calling thread
+struct ws_stats {
+    unsigned long long attempts;  // steal() calls on a deque that was not seen empty
+    unsigned long long steals;    // Of those, steals that won the element
+};
+
+ws_stats ws_get_stats();  // Read the work-stealing counters
+
+template <typename T>
+class ws_deque {
+    static_assert(is_trivially_copyable_v<T>, "thieves copy the element before claiming it");
+
+    public:
+        CACHE_ALIGNED atomic<long long> top;     // Next position to steal, advanced by thieves and the owner's last pop
+        CACHE_ALIGNED atomic<long long> bottom;  // Next position to push, written by the owner only
+        atomic<ws_ring<T> *> ring;               // Current ring, replaced by the owner when it grows
+        vector<ws_ring<T> *> old_rings;          // Rings replaced by a grow, freed with the deque (owner only)
+
+        ws_deque() : top(0), bottom(0), ring(new ws_ring<T>(WS_INITIAL_CAPACITY)) {}
+        ~ws_deque();
+        void push(const T &element);   // Owner: push at the bottom, growing the ring when full
+        bool pop(T &element);          // Owner: pop the element pushed last
+        bool steal(T &element);        // Any thread: take the oldest element; false if empty or lost to another thread
+        ws_ring<T> *grow(ws_ring<T> *old, long long b, long long t);  // Owner: copy [t, b) into a ring twice as large
+};
+
+// Lock-free skiplist priority queue (Linden, Jonsson 2013). delete_min does not unlink the node it takes:
+// it sets the low bit of its predecessor's level-0 next pointer with one fetch_or, so the deleted nodes form
+// a prefix of the bottom list and concurrent delete_mins walk over it instead of fighting over one pointer.
+// Once a delete_min has walked PQ_BOUND_OFFSET deleted nodes, it cuts the whole prefix off with one CAS on
+// head and fixes up head's upper levels. insert is the lock-free skiplist insert of Fraser, which never
+// links a node into the deleted prefix.
+// HP cannot protect a skiplist walk with a fixed number of hazards, so only leak and EBR are instantiated.
+#define PQ_MAX_LEVEL    (24)  // Levels of the skiplist (enough for 2^24 keys at p = 1/2)
+#define PQ_BOUND_OFFSET (32)  // Deleted nodes a delete_min walks before it cuts the prefix off
+#define PQ_DELETED      ((uintptr_t)1)  // Low bit of a level-0 next pointer: the node it points to is deleted
+
+// Skiplist node, allocated with its next array right behind it
+template <typename T>
+struct pq_node {
+    T key;                       // Priority, smallest first
+    int level;                   // Levels this node is linked on
+    atomic<bool> inserting;      // Upper levels still being linked; delete_min does not cut the prefix past it
+    atomic<uintptr_t> *next;     // next[0..level); next[0] carries PQ_DELETED, the upper levels never do
+
+    pq_node(const T &key, int level) : key(key), level(level), inserting(true), next(nullptr) {}
+
+    static size_t size(int level) { return sizeof(pq_node) + level * sizeof(atomic<uintptr_t>); }
+    static pq_node *create(const T &key, int level) {  // Allocate a node and its next array from the pool
+        pq_node *temp = new (pool_allocate(size(level))) pq_node(key, level);
+        temp->next = reinterpret_cast<atomic<uintptr_t> *>(temp + 1);
+        for (int i = 0; i < level; i++) {
+            new (&temp->next[i]) atomic<uintptr_t>(0);
+        }
+        return temp;
+    }
+    static void destroy(void *ptr) {  // Deleter handed to the reclamation policy
+        pq_node *temp = static_cast<pq_node *>(ptr);
+        int level = temp->level;
+        temp->~pq_node();
+        pool_free(temp, size(level));
+    }
+};
+
+template <typename T>
+pq_node<T> *pq_unmark(uintptr_t link) { return reinterpret_cast<pq_node<T> *>(link & ~PQ_DELETED); }
+
+template <typename T, typename Reclaimer = epoch_reclaimer>
+class skiplist_pq {
+    public:
+        pq_node<T> *head;  // Sentinel on every level; its level-0 link is marked once the first key was deleted
+        pq_node<T> *tail;  // Sentinel greater than every key
+
+        skiplist_pq();
+        ~skiplist_pq();
+        void insert(const T &key);    // Insert a key (duplicates allowed)
+        bool delete_min(T &key);      // Remove the smallest key; false if the queue is empty
+        pq_node<T> *locate_preds(const T &key, pq_node<T> **preds, pq_node<T> **succs);  // Insert position per level, skipping the deleted prefix
+        void restructure();           // Move head's upper levels past the deleted prefix after a cut
+        bool before(pq_node<T> *cur, const T &key) { return cur != tail && cur->key < key; }
+};
+
+// Flat combining (Hendler, Incze, Shavit, Tzafrir 2010): a thread publishes its request in its own
+// record and spins on that record only. Whoever takes the combiner lock scans the publication list once
+// and applies every pending request to a sequential structure that only the combiner touches.
+#define FC_NONE (0)  // No request pending (set by the combiner once a request is served)
+#define FC_PUSH (1)  // Push/insert record.element
+#define FC_POP  (2)  // Pop/remove into record.element, record.result says whether there was one
+#define FC_SPIN (64) // Polls of the own record between attempts to become the combiner
+#define FC_MAX_PASSES (4)          // Passes over the publication list per combining session (bounds the combiner)
+#define FC_AGE_LIMIT (1024)        // Passes without a request after which a record is unlinked
+#define FC_CLEANUP_INTERVAL (64)   // Every this many passes the combiner also evicts aged records
+
+int fc_thread_index();  // Index of the calling thread's publication record (< MAX_THREADS, reused after thread exit)
+
+// Publication record of one thread, on its own cache line so waiting threads do not disturb each other
+template <typename T>
+struct CACHE_ALIGNED fc_record {
+    atomic<int> request;          // FC_NONE, FC_PUSH or FC_POP
+    T element;                    // Pushed element, or popped element once served
+    bool result;                  // Pop found an element
+    atomic<bool> active;          // Record is linked in the publication list
+    atomic<fc_record *> next;     // Next record of the publication list
+    unsigned age;                 // Combiner pass that last served this record (combiner only)
+
+    fc_record() : request(FC_NONE), element(), result(false), active(false), next(nullptr), age(0) {}
+};
+
+// Applies the collected requests to the sequential structure: (container, pending records, count)
+template <typename T>
+using fc_apply = void (*)(void *, fc_record<T> **, size_t);
+
+// Publication list and combiner lock shared by the flat-combining containers
+template <typename T, typename Lock = mcs_lock>
+class flat_combiner {
+    public:
+        Lock lock;                                       // Combiner lock
+        CACHE_ALIGNED atomic<fc_record<T> *> pub_head;   // Publication list, records are only ever added at the head
+        vector<fc_record<T>> records;      // One record per thread index
+        unsigned passes;                   // Combining passes so far (combiner only), the clock for record aging
+
+        flat_combiner() : pub_head(nullptr), records(MAX_THREADS), passes(0) {}
+
+        fc_record<T> &my_record() { return records[fc_thread_index()]; }  // Calling thread's record
+        void execute(fc_record<T> &rec, int request, fc_apply<T> apply, void *container);  // Publish and wait until served
+        void combine(fc_apply<T> apply, void *container);  // Serve pending requests for at most FC_MAX_PASSES passes (lock held)
+        void acquire(typename Lock::node &n, fc_apply<T> apply, void *container);  // Take the lock for a bulk operation, serving waiters first
+        void release(typename Lock::node &n) { lock.unlock(n); }
+        void enlist(fc_record<T> &rec);   // Link a record at the head of the publication list
+};
+
+// Flat-combining queue: the combiner applies all pending inserts and removes to a plain linked queue
+template <typename T, typename Lock = mcs_lock>
+class queue_flat {
+    public:
+        flat_combiner<T, Lock> fc;      // Publication records and combiner lock
+        queue_node<T> *head;      // Front of the sequential queue (combiner only)
+        queue_node<T> *tail;      // Rear of the sequential queue (combiner only)
+
+        park_gate gate;                    // Parks pop_wait callers while the queue is empty
+        queue_flat() : head(nullptr), tail(nullptr) {}
+        template <typename U>
+        void insert(U &&element) {  // Publish an insert and wait for a combiner to apply it
+            fc_record<T> &rec = fc.my_record();
+            rec.element = forward<U>(element);
+            fc.execute(rec, FC_PUSH, apply, this);
+            gate.notify();
+        }
+        bool remove(T &element);   // Publish a remove and wait for a combiner to apply it
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the queue is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Insert a range of elements with one combiner lock hold
+            queue_node<T> *tail;
+            queue_node<T> *head = make_queue_chain(first, last, tail);
+            if (head) {
+                insert_chain(head, tail);
+            }
+        }
+        void insert_chain(queue_node<T> *first, queue_node<T> *last);  // Link a private chain at the tail
+        size_t pop_bulk(T *out, size_t max);  // Remove up to max elements with one combiner lock hold
+        static void apply(void *self, fc_record<T> **pending, size_t count);  // Combiner: apply requests in list order
+};
+
+// Flat-combining stack: the combiner pairs pending pushes with pending pops in one linear pass and only
+// the unmatched remainder touches the plain linked stack
+template <typename T, typename Lock = mcs_lock>
+class stack_flat {
+    public:
+        flat_combiner<T, Lock> fc;       // Publication records and combiner lock
+        CACHE_ALIGNED stack_node<T> *top;        // Top of the sequential stack (combiner only)
+
+        park_gate gate;                    // Parks pop_wait callers while the stack is empty
+        stack_flat() : top(nullptr) {}
+        template <typename U>
+        void push(U &&element) {   // Publish a push and wait for a combiner to apply it
+            fc_record<T> &rec = fc.my_record();
+            rec.element = forward<U>(element);
+            fc.execute(rec, FC_PUSH, apply, this);
+            gate.notify();
+        }
+        bool pop(T &element);      // Publish a pop and wait for a combiner to apply it
+        void pop_wait(T &element) { park_pop(*this, element, PARK_FOREVER); }  // Pop, parking while the stack is empty
+        bool pop_wait_for(T &element, chrono::nanoseconds timeout) { return park_pop(*this, element, timeout.count()); }  // Same, false after timeout
+        template <typename It>
+        void push_bulk(It first, It last) {  // Push a range of elements with one combiner lock hold
+            stack_node<T> *tail;
+            stack_node<T> *head = make_stack_chain(first, last, tail);
+            if (head) {
+                push_chain(head, tail);
+            }
+        }
+        void push_chain(stack_node<T> *first, stack_node<T> *last);  // Link a private chain on top of the stack
+        size_t pop_bulk(T *out, size_t max);  // Pop up to max elements with one combiner lock hold
+        static void apply(void *self, fc_record<T> **pending, size_t count);  // Combiner: eliminate, then apply the rest
+};
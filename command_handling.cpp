@@ -1,97 +1,395 @@
-#include "command_handling.hpp"  // Include header file for command handling functionality
-#include <cstring>  // For string manipulation (e.g., strcmp)
-#include <getopt.h>  // For parsing command line options
-
-using namespace std;
-
-// Default number of threads for parallelism
-unsigned NUM_THREADS = 4;
-
-// Function to handle command line arguments and populate the command_param structure
-int command_handle(int argc, char *argv[], command_param * ch) {
-    int opt = 0;  // Variable to hold option character
-    ch->source_file = nullptr;  // Initialize source file pointer to nullptr
-    ch->out_file = strdup("stack_queue_output.txt");  // Default output file name
-    ch->stack = nullptr;  // Initialize stack to nullptr
-    ch->queue = nullptr;  // Initialize queue to nullptr
-    ch->pop_count = 0;  // Default pop count is set to 0
-
-    // Structure to define long options for command line arguments
-    static struct option long_options[] = {
-        {"stack", required_argument, 0, 0},  // Stack option, requires an argument
-        {"queue", required_argument, 0, 0},  // Queue option, requires an argument
-        {"pop", required_argument, 0, 0},    // Pop count option, requires an argument
-        {0, 0, 0, 0}  // End of long options
-    };
-    int option_index = 0;  // Index for long options
-
-    // Parse command line arguments using getopt_long
-    while ((opt = getopt_long(argc, argv, "i:o:t:h", long_options, &option_index)) != -1) {
-        switch (opt) {
-            case 0:  // Handle long options
-                cout << "option --> " << long_options[option_index].name << ": ";
-                if (strcmp(long_options[option_index].name, "stack") == 0) {
-                    cout << optarg << endl;  // Display the value for the stack option
-                    ch->stack = optarg;  // Store the stack type
-                }
-                if (strcmp(long_options[option_index].name, "queue") == 0) {
-                    cout << optarg << endl;  // Display the value for the queue option
-                    ch->queue = optarg;  // Store the queue type
-                }
-                if (strcmp(long_options[option_index].name, "pop") == 0) {
-                    cout << optarg << endl;  // Display the value for the pop option
-                    ch->pop_count = atoi(optarg);  // Convert string to integer and store the pop count
-                }
-                break;
-            case 'i':  // Handle input file option
-                cout << "option --> " << static_cast<char>(opt) << ":";
-                if (optarg) {
-                    cout << optarg;  // Display the input file name
-                    ch->source_file = optarg;  // Store the input file name
-                }
-                cout << endl;
-                break;
-            case 'o':  // Handle output file option
-                cout << "option --> " << static_cast<char>(opt) << ":";
-                if (optarg) {
-                    cout << optarg;  // Display the output file name
-                    ch->out_file = optarg;  // Store the output file name
-                }
-                cout << endl;
-                break;
-            case 't':  // Handle number of threads option
-                cout << "option --> " << static_cast<char>(opt) << ":";
-                if (optarg) {
-                    cout << optarg;  // Display the number of threads
-                    NUM_THREADS = atoi(optarg);  // Convert string to integer and store the number of threads
-                }
-                cout << endl;
-                break;
-            case 'h':  // Display usage information
-                cout << "Usage: ./container [-i source.txt] [-o out.txt] [-t NUMTHREADS] [--stack=<sgl,treiber,sgl_elim,treiber_elim,stack_flat>] [--queue=<sgl,mns>]"
-                     << endl; // not enough time to implement [--pop=<pop_count>]
-                cout << "-i : file containing elements to insert into stack or queue" << endl;
-                cout << "-o : file to store remaining elements in stack or queue" << endl;
-                cout << "-t : Number of threads for parallelism" << endl;
-                cout << "--stack : stack type (e.g., sgl, treiber)" << endl;
-                cout << "--queue : queue type (e.g., sgl, m&s)" << endl;
-                cout << "--pop : # of elements to pop from the stack or queue" << endl;
-                return EXIT_FAILURE;  // Exit the program with failure status
-                break;
-            default:  // If an unknown option is passed, display usage information
-                cout << "Usage: ./container [-i source.txt] [-o out.txt] [-t NUMTHREADS] [--stack=<sgl,treiber,sgl_elim,treiber_elim,stack_flat>] [--queue=<sgl,mns>]"
-                     << endl; // not enough time to implement [--pop=<pop_count>]
-                return EXIT_FAILURE;  // Exit with failure status
-        }
-    }
-
-    // Validate that the required parameters are specified
-    if (!ch->source_file || (!ch->stack && !ch->queue)) {
-        cout << "All parameters not specified correctly, please check and try again!!!" << endl;
-        cout << "Usage: ./container [-i source.txt] [-o out.txt] [-t NUMTHREADS] [--stack=<sgl,treiber,sgl_elim,treiber_elim,stack_flat>] [--queue=<sgl,mns>]"
-                     << endl; // not enough time to implement [--pop=<pop_count>]
-        return EXIT_FAILURE;  // Exit with failure status
-    }
-
-    return EXIT_SUCCESS;  // Successfully parsed the command line arguments
-}
+#include "command_handling.hpp"  // Include header file for command handling functionality
+#include "buffer.hpp"  // For MAX_THREADS (reclamation.hpp needs the memory-order macros of buffer.hpp)
+#include <cstring>  // For string manipulation (e.g., strcmp)
+#include <getopt.h>  // For parsing command line options
+#include <cctype>  // For isdigit
+#include <cerrno>  // For errno (strtol range errors)
+
+using namespace std;
+
+// Default number of threads for parallelism
+unsigned NUM_THREADS = 4;
+
+// Default reclamation policy, lock policy, number of passes over the input and driver batch size
+unsigned RECLAIM_POLICY = RECLAIM_EBR;
+unsigned LOCK_POLICY = LOCK_MCS;
+unsigned BENCH_ROUNDS = 1;
+unsigned BATCH_SIZE = 1;
+
+// Default capacity of the bounded ring queue
+unsigned RING_CAPACITY = 1024;
+
+// Default park timeout of the drivers' pops in microseconds (0: never park, retry pop instead)
+unsigned WAIT_TIMEOUT_US = 0;
+
+// Shards of the relaxed multi stack/queue (0: twice the number of threads) and rank-error measurement
+unsigned MULTI_SHARDS = 0;
+bool RANK_ERROR = false;
+
+// Priority queue runs: overlap the inserts with delete_min instead of separating them with a barrier
+bool PQ_OVERLAP = false;
+
+// Synthetic workload: off until --ops or --duration is given; by default an even push/pop mix on every
+// thread over uniform keys from [0, 1000000) on an empty buffer
+bool WORKLOAD = false;
+unsigned long long WORKLOAD_OPS = 0;
+unsigned WORKLOAD_DURATION_MS = 0;
+unsigned PUSH_PERCENT = 50;
+unsigned PRODUCERS = 0;
+unsigned CONSUMERS = 0;
+unsigned KEY_DIST = KEYS_UNIFORM;
+unsigned KEY_RANGE = 1000000;
+unsigned long long PREFILL = 0;
+
+// Per-operation latency histograms of the drivers' push and pop calls
+bool LATENCY = false;
+
+// Placement of the driver threads (default: unpinned)
+unsigned AFFINITY_POLICY = AFFINITY_NONE;
+char *AFFINITY_CPUS = nullptr;
+
+// Binary copy of the input written by --save-binary
+char *SAVE_BINARY = nullptr;
+
+// One-line usage printed by -h and on every parse error (not enough time to implement [--pop=<pop_count>])
+static const char *USAGE = "Usage: ./container [-i source.txt] [-o out.txt] [-t NUMTHREADS] [--stack=<sgl,treiber,treiber_tagged,sgl_elim,treiber_elim,stack_flat,dual,multi,chase_lev>] [--queue=<sgl,twolock,mns,mns_elim,flat,faa,ring,spsc,dual,multi>] [--pq=<skiplist>] [--overlap] [--reclaim=<leak,hp,ebr>] [--lock=<tas,ttas,ticket,mcs,clh>] [--bench=<rounds>] [--batch=<size>] [--capacity=<slots>] [--wait=<us>] [--shards=<n>] [--rank] [--ops=<n> | --duration=<ms>] [--mix=<push%>] [--producers=<n>] [--consumers=<n>] [--keys=<uniform,zipf,sequential>] [--key-range=<n>] [--prefill=<n>] [--latency] [--affinity=<compact,scatter,cpu list>] [--save-binary=<file>]";
+
+// Parse arg as a whole decimal number in [min, max]; false for an empty argument, trailing characters
+// or a value out of range (strtol instead of atoi, so "-1" is not silently wrapped into an unsigned)
+static bool parse_number(const char *arg, long min, long max, long &value) {
+    char *end;
+    errno = 0;
+    value = strtol(arg, &end, 10);
+    return end != arg && *end == '\0' && errno == 0 && value >= min && value <= max;
+}
+
+// Function to handle command line arguments and populate the command_param structure
+int command_handle(int argc, char *argv[], command_param * ch) {
+    int opt = 0;  // Variable to hold option character
+    ch->source_file = nullptr;  // Initialize source file pointer to nullptr
+    ch->out_file = strdup("stack_queue_output.txt");  // Default output file name
+    ch->stack = nullptr;  // Initialize stack to nullptr
+    ch->queue = nullptr;  // Initialize queue to nullptr
+    ch->pq = nullptr;  // Initialize priority queue to nullptr
+    ch->pop_count = 0;  // Default pop count is set to 0
+
+    // Structure to define long options for command line arguments
+    static struct option long_options[] = {
+        {"stack", required_argument, 0, 0},  // Stack option, requires an argument
+        {"queue", required_argument, 0, 0},  // Queue option, requires an argument
+        {"pq", required_argument, 0, 0},     // Priority queue option, requires an argument
+        {"pop", required_argument, 0, 0},    // Pop count option, requires an argument
+        {"reclaim", required_argument, 0, 0},  // Reclamation policy option, requires an argument
+        {"lock", required_argument, 0, 0},   // Lock policy option, requires an argument
+        {"bench", required_argument, 0, 0},  // Benchmark rounds option, requires an argument
+        {"batch", required_argument, 0, 0},  // Batch size option, requires an argument
+        {"capacity", required_argument, 0, 0},  // Ring queue capacity option, requires an argument
+        {"wait", required_argument, 0, 0},   // Park timeout option, requires an argument
+        {"shards", required_argument, 0, 0}, // Shard count option, requires an argument
+        {"rank", no_argument, 0, 0},         // Rank-error measurement option, takes no argument
+        {"overlap", no_argument, 0, 0},      // Overlapping priority queue phases option, takes no argument
+        {"ops", required_argument, 0, 0},    // Workload operation count option, requires an argument
+        {"duration", required_argument, 0, 0},  // Workload duration option, requires an argument
+        {"mix", required_argument, 0, 0},    // Workload push percentage option, requires an argument
+        {"producers", required_argument, 0, 0},  // Push-only thread count option, requires an argument
+        {"consumers", required_argument, 0, 0},  // Pop-only thread count option, requires an argument
+        {"keys", required_argument, 0, 0},   // Key distribution option, requires an argument
+        {"key-range", required_argument, 0, 0},  // Key range option, requires an argument
+        {"prefill", required_argument, 0, 0},    // Prefill size option, requires an argument
+        {"latency", no_argument, 0, 0},      // Latency histogram option, takes no argument
+        {"affinity", required_argument, 0, 0},  // Thread placement option, requires an argument
+        {"save-binary", required_argument, 0, 0},  // Binary input conversion option, requires an argument
+        {0, 0, 0, 0}  // End of long options
+    };
+    int option_index = 0;  // Index for long options
+
+    // Parse command line arguments using getopt_long
+    while ((opt = getopt_long(argc, argv, "i:o:t:h", long_options, &option_index)) != -1) {
+        switch (opt) {
+            case 0:  // Handle long options
+                cout << "option --> " << long_options[option_index].name << ": ";
+                if (strcmp(long_options[option_index].name, "stack") == 0) {
+                    cout << optarg << endl;  // Display the value for the stack option
+                    ch->stack = optarg;  // Store the stack type
+                }
+                if (strcmp(long_options[option_index].name, "queue") == 0) {
+                    cout << optarg << endl;  // Display the value for the queue option
+                    ch->queue = optarg;  // Store the queue type
+                }
+                if (strcmp(long_options[option_index].name, "pq") == 0) {
+                    cout << optarg << endl;  // Display the value for the priority queue option
+                    ch->pq = optarg;  // Store the priority queue type
+                }
+                if (strcmp(long_options[option_index].name, "pop") == 0) {
+                    cout << optarg << endl;  // Display the value for the pop option
+                    ch->pop_count = atoi(optarg);  // Convert string to integer and store the pop count
+                }
+                if (strcmp(long_options[option_index].name, "reclaim") == 0) {
+                    cout << optarg << endl;  // Display the value for the reclaim option
+                    if (strcmp(optarg, "leak") == 0) {
+                        RECLAIM_POLICY = RECLAIM_LEAK;
+                    } else if (strcmp(optarg, "hp") == 0) {
+                        RECLAIM_POLICY = RECLAIM_HP;
+                    } else if (strcmp(optarg, "ebr") == 0) {
+                        RECLAIM_POLICY = RECLAIM_EBR;
+                    } else {
+                        cout << "Unknown reclamation policy " << optarg << ", expected leak, hp or ebr" << endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "lock") == 0) {
+                    cout << optarg << endl;  // Display the value for the lock option
+                    if (strcmp(optarg, "tas") == 0) {
+                        LOCK_POLICY = LOCK_TAS;
+                    } else if (strcmp(optarg, "ttas") == 0) {
+                        LOCK_POLICY = LOCK_TTAS;
+                    } else if (strcmp(optarg, "ticket") == 0) {
+                        LOCK_POLICY = LOCK_TICKET;
+                    } else if (strcmp(optarg, "mcs") == 0) {
+                        LOCK_POLICY = LOCK_MCS;
+                    } else if (strcmp(optarg, "clh") == 0) {
+                        LOCK_POLICY = LOCK_CLH;
+                    } else {
+                        cout << "Unknown lock policy " << optarg << ", expected tas, ttas, ticket, mcs or clh" << endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "bench") == 0) {
+                    cout << optarg << endl;  // Display the number of benchmark rounds
+                    long rounds;
+                    if (!parse_number(optarg, 0, BENCH_MAX_ROUNDS, rounds)) {
+                        cout << "--bench takes a number of rounds up to " << BENCH_MAX_ROUNDS << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    BENCH_ROUNDS = rounds ? rounds : 1;  // Each round pushes and pops the whole input once
+
+                }
+                if (strcmp(long_options[option_index].name, "batch") == 0) {
+                    cout << optarg << endl;  // Display the batch size
+                    long batch;
+                    if (!parse_number(optarg, 0, BATCH_MAX_SIZE, batch)) {
+                        cout << "--batch takes a batch size up to " << BATCH_MAX_SIZE << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    BATCH_SIZE = batch ? batch : 1;  // Elements moved per push_bulk/pop_bulk call
+                }
+                if (strcmp(long_options[option_index].name, "capacity") == 0) {
+                    cout << optarg << endl;  // Display the ring queue capacity
+                    long capacity;
+                    if (!parse_number(optarg, 1, RING_MAX_CAPACITY, capacity)) {
+                        cout << "--capacity takes a number of slots from 1 to " << RING_MAX_CAPACITY << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    RING_CAPACITY = capacity;  // Rounded up to a power of two by the ring queue
+                }
+                if (strcmp(long_options[option_index].name, "wait") == 0) {
+                    cout << optarg << endl;  // Display the park timeout
+                    long timeout;
+                    if (!parse_number(optarg, 0, WAIT_MAX_TIMEOUT_US, timeout)) {
+                        cout << "--wait takes a park timeout from 0 to " << WAIT_MAX_TIMEOUT_US << " microseconds" << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    WAIT_TIMEOUT_US = timeout;  // Pops go through pop_wait_for with this timeout
+                }
+                if (strcmp(long_options[option_index].name, "shards") == 0) {
+                    cout << optarg << endl;  // Display the shard count
+                    long shards;
+                    // 0 keeps the default (2 * NUM_THREADS); anything else must be a shard count in range
+                    if (!parse_number(optarg, 0, MULTI_MAX_SHARDS, shards)) {
+                        cout << "--shards takes a number from 1 to " << MULTI_MAX_SHARDS << " (or 0 for the default)" << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    MULTI_SHARDS = shards;  // Shards of the multi stack/queue
+                }
+                if (strcmp(long_options[option_index].name, "rank") == 0) {
+                    cout << "on" << endl;  // No argument to display
+                    RANK_ERROR = true;  // Log pushes and pops of the multi stack/queue and report the rank error
+                }
+                if (strcmp(long_options[option_index].name, "overlap") == 0) {
+                    cout << "on" << endl;  // No argument to display
+                    PQ_OVERLAP = true;  // delete_min calls start while other threads still insert
+                }
+                if (strcmp(long_options[option_index].name, "affinity") == 0) {
+                    cout << optarg << endl;  // Display the value for the affinity option
+                    if (strcmp(optarg, "compact") == 0) {
+                        AFFINITY_POLICY = AFFINITY_COMPACT;
+                    } else if (strcmp(optarg, "scatter") == 0) {
+                        AFFINITY_POLICY = AFFINITY_SCATTER;
+                    } else if (isdigit((unsigned char)optarg[0])) {
+                        AFFINITY_POLICY = AFFINITY_LIST;
+                        AFFINITY_CPUS = strdup(optarg);  // Expanded into CPUs in main
+                    } else {
+                        cout << "Unknown affinity " << optarg << ", expected compact, scatter or a CPU list like 0,2,4-7" << endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "save-binary") == 0) {
+                    cout << optarg << endl;  // Display the binary file name
+                    SAVE_BINARY = strdup(optarg);  // Written by main after loading -i
+                }
+                if (strcmp(long_options[option_index].name, "latency") == 0) {
+                    cout << "on" << endl;  // No argument to display
+                    LATENCY = true;  // Time every push and pop call and report percentiles
+                }
+                if (strcmp(long_options[option_index].name, "ops") == 0) {
+                    cout << optarg << endl;  // Display the operation count
+                    WORKLOAD_OPS = strtoull(optarg, nullptr, 10);  // Split evenly over the threads
+                    WORKLOAD = true;
+                }
+                if (strcmp(long_options[option_index].name, "duration") == 0) {
+                    cout << optarg << endl;  // Display the duration
+                    long duration;
+                    if (!parse_number(optarg, 1, WORKLOAD_MAX_DURATION_MS, duration)) {
+                        cout << "--duration takes a number of milliseconds from 1 to " << WORKLOAD_MAX_DURATION_MS << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    WORKLOAD_DURATION_MS = duration;  // Every thread runs until its clock passes it
+                    WORKLOAD = true;
+                }
+                if (strcmp(long_options[option_index].name, "mix") == 0) {
+                    cout << optarg << endl;  // Display the push percentage
+                    PUSH_PERCENT = atoi(optarg);  // The rest of a mixed thread's operations are pops
+                    if (PUSH_PERCENT > 100) {
+                        PUSH_PERCENT = 100;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "producers") == 0) {
+                    cout << optarg << endl;  // Display the producer count
+                    long producers;
+                    if (!parse_number(optarg, 0, MAX_THREADS, producers)) {
+                        cout << "--producers takes a thread count from 0 to " << MAX_THREADS << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    PRODUCERS = producers;
+                }
+                if (strcmp(long_options[option_index].name, "consumers") == 0) {
+                    cout << optarg << endl;  // Display the consumer count
+                    long consumers;
+                    if (!parse_number(optarg, 0, MAX_THREADS, consumers)) {
+                        cout << "--consumers takes a thread count from 0 to " << MAX_THREADS << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    CONSUMERS = consumers;
+                }
+                if (strcmp(long_options[option_index].name, "keys") == 0) {
+                    cout << optarg << endl;  // Display the key distribution
+                    if (strcmp(optarg, "uniform") == 0) {
+                        KEY_DIST = KEYS_UNIFORM;
+                    } else if (strcmp(optarg, "zipf") == 0) {
+                        KEY_DIST = KEYS_ZIPF;
+                    } else if (strcmp(optarg, "sequential") == 0) {
+                        KEY_DIST = KEYS_SEQUENTIAL;
+                    } else {
+                        cout << "Unknown key distribution " << optarg << ", expected uniform, zipf or sequential" << endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "key-range") == 0) {
+                    cout << optarg << endl;  // Display the key range
+                    KEY_RANGE = atoi(optarg);
+                    if (KEY_RANGE == 0) {
+                        KEY_RANGE = 1;
+                    }
+                }
+                if (strcmp(long_options[option_index].name, "prefill") == 0) {
+                    cout << optarg << endl;  // Display the prefill size
+                    PREFILL = strtoull(optarg, nullptr, 10);  // Pushed (split over the threads) before the clock starts
+                }
+                break;
+            case 'i':  // Handle input file option
+                cout << "option --> " << static_cast<char>(opt) << ":";
+                if (optarg) {
+                    cout << optarg;  // Display the input file name
+                    ch->source_file = optarg;  // Store the input file name
+                }
+                cout << endl;
+                break;
+            case 'o':  // Handle output file option
+                cout << "option --> " << static_cast<char>(opt) << ":";
+                if (optarg) {
+                    cout << optarg;  // Display the output file name
+                    ch->out_file = optarg;  // Store the output file name
+                }
+                cout << endl;
+                break;
+            case 't':  // Handle number of threads option
+                cout << "option --> " << static_cast<char>(opt) << ":";
+                if (optarg) {
+                    cout << optarg;  // Display the number of threads
+                    long threads;
+                    // Per-thread records (reclamation, flat combining, workload results) exist for MAX_THREADS threads
+                    if (!parse_number(optarg, 1, MAX_THREADS, threads)) {
+                        cout << endl << "-t takes a thread count from 1 to " << MAX_THREADS << endl;
+                        cout << USAGE << endl;
+                        return EXIT_FAILURE;
+                    }
+                    NUM_THREADS = threads;  // Store the number of threads
+                }
+                cout << endl;
+                break;
+            case 'h':  // Display usage information
+                cout << USAGE << endl;
+                cout << "-i : file containing elements to insert into stack or queue" << endl;
+                cout << "-o : file to store remaining elements in stack or queue" << endl;
+                cout << "-t : Number of threads for parallelism (1 to " << MAX_THREADS << ")" << endl;
+                cout << "--stack : stack type (e.g., sgl, treiber)" << endl;
+                cout << "--queue : queue type (e.g., sgl, m&s)" << endl;
+                cout << "--pq : priority queue type (skiplist); each thread inserts its share, then deletes the minimum until empty" << endl;
+                cout << "--overlap : with --pq, every thread calls delete_min after every second insert, so deletes run against concurrent inserts, then drains the queue" << endl;
+                cout << "--pop : # of elements to pop from the stack or queue" << endl;
+                cout << "--stack=chase_lev : one work-stealing deque per thread, seeded with the thread's share of the input; empty threads steal (ignores --batch and --wait)" << endl;
+                cout << "--reclaim : memory reclamation for treiber, treiber_elim, mns, mns_elim, faa, the dual stack/queue and the skiplist pq (leak, hp, ebr; default ebr; the pq runs hp as ebr)" << endl;
+                cout << "--lock : lock of sgl, sgl_elim, stack_flat, flat and twolock (tas, ttas, ticket, mcs, clh; default mcs)" << endl;
+                cout << "--batch : push and pop this many elements per call with push_bulk/pop_bulk (default 1)" << endl;
+                cout << "--capacity : capacity of the ring and spsc queues, rounded up to a power of two (default 1024)" << endl;
+                cout << "--wait : pop with pop_wait_for, parking up to this many microseconds on an empty buffer (default 0: spin on pop)" << endl;
+                cout << "--shards : shards of the multi stack and queue (default twice the number of threads)" << endl;
+                cout << "--rank : log the pushes and pops of the multi stack or queue and report how far they drift from strict LIFO/FIFO order (slow)" << endl;
+                cout << "--bench : benchmark mode, push and pop the input this many times and report throughput and peak RSS" << endl;
+                cout << "--ops : synthetic workload instead of -i, this many operations split over the threads" << endl;
+                cout << "--duration : synthetic workload instead of -i, every thread runs for this many milliseconds" << endl;
+                cout << "--mix : percentage of pushes among the operations of a mixed thread (default 50)" << endl;
+                cout << "--producers / --consumers : the first n threads only push, the next m only pop, the rest follow --mix (default 0)" << endl;
+                cout << "--keys : key distribution of the workload (uniform, zipf, sequential; default uniform)" << endl;
+                cout << "--key-range : workload keys are drawn from [0, n) (default 1000000)" << endl;
+                cout << "--prefill : elements pushed before the workload clock starts (default 0)" << endl;
+                cout << "--latency : time every push and pop call with the TSC and report p50/p90/p99/p99.9/max per operation" << endl;
+                cout << "--affinity : pin thread i to the i-th CPU of compact (siblings, cores, packages) or scatter (packages, cores, siblings) order, or of a CPU list like 0,2,4-7" << endl;
+                cout << "--save-binary : write the -i input as a binary input file (loaded without parsing when passed to -i) and exit" << endl;
+                return EXIT_FAILURE;  // Exit the program with failure status
+                break;
+            default:  // If an unknown option is passed, display usage information
+                cout << USAGE << endl;
+                return EXIT_FAILURE;  // Exit with failure status
+        }
+    }
+
+    // Validate that the required parameters are specified (the workload generates its own input)
+    if ((!ch->source_file && !WORKLOAD) || (!ch->stack && !ch->queue && !ch->pq)) {
+        cout << "All parameters not specified correctly, please check and try again!!!" << endl;
+        cout << USAGE << endl;
+        return EXIT_FAILURE;  // Exit with failure status
+    }
+
+    // Flat combining gives every thread a publication record; fc_thread_index has MAX_THREADS of them
+    bool flat = (ch->stack && strcmp(ch->stack, "stack_flat") == 0) || (ch->queue && strcmp(ch->queue, "flat") == 0);
+    if (flat && NUM_THREADS > MAX_THREADS) {
+        cout << "Flat combining has publication records for " << MAX_THREADS << " threads, " << NUM_THREADS << " given" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (WORKLOAD && PRODUCERS + CONSUMERS > NUM_THREADS) {
+        cout << "--producers and --consumers need " << PRODUCERS + CONSUMERS << " threads, only " << NUM_THREADS << " given" << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;  // Successfully parsed the command line arguments
+}
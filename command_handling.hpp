@@ -1,26 +1,79 @@
-#include <iostream> // Standard library for input and output operations
-
-// Structure to hold command-line parameters
-struct command_param {
-    char* source_file; // Pointer to a string holding the source file name
-    char* out_file;    // Pointer to a string holding the output file name
-    char* stack;       // Pointer to a string specifying stack operations
-    char* queue;       // Pointer to a string specifying queue operations
-    unsigned pop_count;// Unsigned integer specifying the number of elements to pop
-};
-typedef struct command_param command_param; // Typedef for ease of use
-
-// Global variable declaration for the number of threads
-extern unsigned NUM_THREADS; // Declared elsewhere; shared across files in the project
-
-// Function prototype for handling command-line arguments
-int command_handle(int argc, char *argv[], command_param *ch);
-/*
- * Parameters:
- * - `argc`: Number of command-line arguments passed to the program
- * - `argv`: Array of character pointers representing the command-line arguments
- * - `ch`: Pointer to a `command_param` structure to store parsed parameters
- *
- * Return Value:
- * - Returns an integer indicating success or failure (likely `EXIT_SUCCESS` or `EXIT_FAILURE`).
- */
+#include <iostream> // Standard library for input and output operations
+
+// Structure to hold command-line parameters
+struct command_param {
+    char* source_file; // Pointer to a string holding the source file name
+    char* out_file;    // Pointer to a string holding the output file name
+    char* stack;       // Pointer to a string specifying stack operations
+    char* queue;       // Pointer to a string specifying queue operations
+    char* pq;          // Pointer to a string specifying the priority queue
+    unsigned pop_count;// Unsigned integer specifying the number of elements to pop
+};
+typedef struct command_param command_param; // Typedef for ease of use
+
+// Reclamation policies selectable with --reclaim for the lock-free containers
+#define RECLAIM_LEAK (0)  // Never free unlinked nodes
+#define RECLAIM_HP   (1)  // Hazard pointers
+#define RECLAIM_EBR  (2)  // Epoch-based reclamation
+
+// Lock policies selectable with --lock for the lock-based containers
+#define LOCK_TAS    (0)  // Test-and-set
+#define LOCK_TTAS   (1)  // Test-and-test-and-set with exponential backoff
+#define LOCK_TICKET (2)  // Ticket lock
+#define LOCK_MCS    (3)  // MCS queue lock
+#define LOCK_CLH    (4)  // CLH queue lock
+
+// Thread placement selectable with --affinity
+#define AFFINITY_NONE    (0)  // Leave placement to the scheduler
+#define AFFINITY_COMPACT (1)  // Fill SMT siblings, then cores, then packages
+#define AFFINITY_SCATTER (2)  // Spread over packages and cores first, SMT siblings last
+#define AFFINITY_LIST    (3)  // CPUs listed on the command line
+
+#define MULTI_MAX_SHARDS (65536)  // Largest --shards accepted
+#define BENCH_MAX_ROUNDS (1000000)  // Largest --bench accepted
+#define BATCH_MAX_SIZE   (65536)    // Largest --batch accepted
+#define RING_MAX_CAPACITY (1 << 24) // Largest --capacity accepted (a power of two, so rounding cannot overflow)
+#define WAIT_MAX_TIMEOUT_US (1000000) // Longest --wait park timeout accepted (one second)
+#define WORKLOAD_MAX_DURATION_MS (86400000)  // Longest --duration accepted (one day)
+
+// Key distributions of the synthetic workload, selectable with --keys
+#define KEYS_UNIFORM    (0)  // Every key of [0, KEY_RANGE) equally likely
+#define KEYS_ZIPF       (1)  // Zipfian over [0, KEY_RANGE), small keys hot
+#define KEYS_SEQUENTIAL (2)  // 0, 1, 2, ... wrapping at KEY_RANGE
+
+// Global variable declaration for the number of threads
+extern unsigned NUM_THREADS; // Declared elsewhere; shared across files in the project
+extern unsigned RECLAIM_POLICY; // Reclamation policy used by treiber, treiber_elim, mns, mns_elim, faa, dual and the skiplist pq
+extern unsigned LOCK_POLICY;    // Lock used by sgl, sgl_elim, stack_flat, flat and twolock
+extern unsigned BENCH_ROUNDS;   // Number of passes over the input (> 1 only in benchmark mode)
+extern unsigned BATCH_SIZE;     // Elements per push_bulk/pop_bulk in the drivers (1: one at a time)
+extern unsigned RING_CAPACITY;  // Capacity of the ring and spsc queues (rounded up to a power of two)
+extern unsigned WAIT_TIMEOUT_US; // Park timeout of the drivers' pops in microseconds (0: plain pop)
+extern unsigned MULTI_SHARDS;   // Shards of the multi stack/queue (0: 2 * NUM_THREADS)
+extern bool RANK_ERROR;         // Measure the rank error of the multi stack/queue
+extern bool PQ_OVERLAP;         // Priority queue: delete_min runs while other threads still insert
+extern bool WORKLOAD;           // Synthetic workload instead of the input file (--ops or --duration)
+extern unsigned long long WORKLOAD_OPS;  // Operations over all threads (0: run for WORKLOAD_DURATION_MS)
+extern unsigned WORKLOAD_DURATION_MS;    // Run length of the workload in milliseconds
+extern unsigned PUSH_PERCENT;   // Share of pushes among the operations of a mixed thread
+extern unsigned PRODUCERS;      // Threads that only push (the first ones)
+extern unsigned CONSUMERS;      // Threads that only pop (the ones after the producers)
+extern unsigned KEY_DIST;       // Key distribution of the workload
+extern unsigned KEY_RANGE;      // Keys are drawn from [0, KEY_RANGE)
+extern unsigned long long PREFILL;  // Elements pushed before the workload starts
+extern bool LATENCY;            // Record per-operation latency histograms
+extern unsigned AFFINITY_POLICY; // Placement of the driver threads
+extern char *AFFINITY_CPUS;     // CPU list of --affinity=<list>
+extern char *SAVE_BINARY;       // Write the input as a binary input file and exit
+
+// Function prototype for handling command-line arguments
+int command_handle(int argc, char *argv[], command_param *ch);
+/*
+ * Parameters:
+ * - `argc`: Number of command-line arguments passed to the program
+ * - `argv`: Array of character pointers representing the command-line arguments
+ * - `ch`: Pointer to a `command_param` structure to store parsed parameters
+ *
+ * Return Value:
+ * - Returns an integer indicating success or failure (likely `EXIT_SUCCESS` or `EXIT_FAILURE`).
+ */
@@ -1,108 +1,333 @@
-/*******************************************************************************
- * Copyright (C) 2024 by Jithendra H S
- *
- * Redistribution, modification, or use of this software in source or binary
- * forms is permitted as long as the files maintain this copyright. Users are
- * permitted to modify this and use it to learn about the field of embedded
- * software. Jithendra H S and the University of Colorado are not liable for
- * any misuse of this material.
- ******************************************************************************/
-
-#include <limits>
-#include <algorithm>
-#include <thread>
-#include <cstring>
-#include "command_handling.hpp"
-#include "buffer.hpp"
-#include "parallelized_code.hpp"
-
-using namespace std;
-
-vector<thread*> threads;
-struct timespec startTime, endTime;
-
-int main(int argc, char *argv[]) {
-    command_param *ch = new command_param();
-    int success = command_handle(argc, argv, ch);
-    if (success == EXIT_FAILURE) {
-        return 0;
-    }
-
-    ifstream fptr_src(ch->source_file);
-    if (!fptr_src) {
-        cout << "Failed to open " << ch->source_file << endl;
-        return EXIT_FAILURE;
-    }
-
-    ofstream fptr_out(ch->out_file);
-    if (!fptr_out) {
-        cout << "Failed to open " << ch->out_file << endl;
-        return EXIT_FAILURE;
-    }
-
-    threads.resize(NUM_THREADS);
-    // Read data from the input file into a vector
-    vector<int> input_data;
-    vector<int> output_data;
-    string line;
-    while (getline(fptr_src, line)) {
-        input_data.push_back(atoi(line.c_str())); // Convert line to integer and add to the vector
-    }
-    output_data.resize(input_data.size() + 10); // adding extra size of 10 to see the abnormalities of stack
-    fill(output_data.begin(), output_data.end(), 0); // Fill all elements with 0
-
-    unsigned buffer_type;
-    // Set buffer type based on command-line arguments (stack or queue)
-    if (ch->stack) {
-        buffer_type = STACK;
-    } else if (ch->queue) {
-        buffer_type = QUEUE;
-    } else {
-        buffer_type = STACK;
-    }
-
-    clock_gettime(CLOCK_MONOTONIC, &startTime);
-    for (unsigned i = 0; i < NUM_THREADS; i++) {
-    // Handle different buffer configurations based on the command-line input
-    if ((ch->stack && strcmp(ch->stack, "sgl") == 0)) {
-          threads[i] = new thread(insert_remove_sgl_stack, ref(input_data), ref(output_data), i, buffer_type);
-    }else if ((ch->queue && strcmp(ch->queue, "sgl") == 0)) {
-          threads[i] = new thread(insert_remove_sgl_queue, ref(input_data), ref(output_data), i, buffer_type);
-    } else if((ch->stack && strcmp(ch->stack, "treiber") == 0)){
-          threads[i] = new thread(insert_remove_treiber, ref(input_data), ref(output_data), i, buffer_type);
-    } else if((ch->queue && strcmp(ch->queue, "mns") == 0)){
-          threads[i] = new thread(insert_remove_mns, ref(input_data), ref(output_data), i, buffer_type);
-    } else if((ch->stack && strcmp(ch->stack, "treiber_elim") == 0)){
-          //cout << "I am here"<< endl;
-          threads[i] = new thread(insert_remove_treiber_elim, ref(input_data), ref(output_data), i, buffer_type);
-    } else if ((ch->stack && strcmp(ch->stack, "sgl_elim") == 0)) {
-         threads[i] = new thread(insert_remove_sgl_elim, ref(input_data), ref(output_data), i, buffer_type);
-    } else if ((ch->stack && strcmp(ch->stack, "stack_flat") == 0)) {
-        threads[i] = new thread(insert_remove_stack_flat, ref(input_data), ref(output_data), i, buffer_type);
-            
-    }
-    }
-
-    // Wait for all threads to finish
-    for (unsigned i = 0; i < NUM_THREADS; i++) {
-        threads[i]->join();
-        delete threads[i];
-    }
-    clock_gettime(CLOCK_MONOTONIC, &endTime);
-    unsigned long long elapsed_ns;
-    elapsed_ns = (endTime.tv_sec - startTime.tv_sec) * 1000000000 +      (endTime.tv_nsec - startTime.tv_nsec);
-    printf("Elapsed (ns): %llu\n", elapsed_ns);
-    double elapsed_s = ((double)elapsed_ns) / 1000000000.0;
-    printf("Elapsed (s): %lf\n", elapsed_s);
-    // Write the sorted data to the output file
-    for (auto i = output_data.begin(); i < output_data.end(); ++i) {
-        fptr_out << *i << "\n";
-    }
-    fptr_src.close();
-    fptr_out.close();
-
-    cout << "Done!!!" << endl;
-
-    return 0;
-}
-
+/*******************************************************************************
+ * Copyright (C) 2024 by Jithendra H S
+ *
+ * Redistribution, modification, or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Jithendra H S and the University of Colorado are not liable for
+ * any misuse of this material.
+ ******************************************************************************/
+
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <sys/resource.h>
+#include "command_handling.hpp"
+#include "buffer.hpp"
+#include "parallelized_code.hpp"
+#include "latency.hpp"
+#include "affinity.hpp"
+#include "loader.hpp"
+
+using namespace std;
+
+vector<thread*> threads;
+struct timespec startTime, endTime;
+
+#define WORKLOAD_POOL_SIZE (1 << 20)  // Keys generated up front for --ops / --duration
+#define ZIPF_THETA (0.99)             // Skew of --keys=zipf (the YCSB default)
+
+/**
+ * Key pool of the synthetic workload, drawn from [0, KEY_RANGE) according to --keys. The zipfian keys use
+ * the generator of Gray et al. (SIGMOD 1994) that YCSB uses, so rank 0 is the most popular key. The pool is
+ * filled once before the threads start; workload_buffer reads it round robin.
+ *
+ * @return WORKLOAD_POOL_SIZE keys
+ */
+static vector<int> generate_keys() {
+    vector<int> keys(WORKLOAD_POOL_SIZE);
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    double zetan = 0.0, alpha = 0.0, eta = 0.0;
+    if (KEY_DIST == KEYS_ZIPF) {
+        for (unsigned i = 1; i <= KEY_RANGE; i++) {
+            zetan += 1.0 / pow((double)i, ZIPF_THETA);
+        }
+        double zeta2 = 1.0 + 1.0 / pow(2.0, ZIPF_THETA);
+        alpha = 1.0 / (1.0 - ZIPF_THETA);
+        eta = (1.0 - pow(2.0 / KEY_RANGE, 1.0 - ZIPF_THETA)) / (1.0 - zeta2 / zetan);
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (KEY_DIST == KEYS_SEQUENTIAL) {
+            keys[i] = i % KEY_RANGE;
+        } else if (KEY_DIST == KEYS_ZIPF) {
+            double u = unit(rng);
+            double uz = u * zetan;
+            if (uz < 1.0) {
+                keys[i] = 0;
+            } else if (uz < 1.0 + pow(0.5, ZIPF_THETA)) {
+                keys[i] = 1;
+            } else {
+                keys[i] = min<unsigned>(KEY_RANGE - 1, KEY_RANGE * pow(eta * u - eta + 1.0, alpha));
+            }
+        } else {
+            keys[i] = rng() % KEY_RANGE;
+        }
+    }
+    return keys;
+}
+
+int main(int argc, char *argv[]) {
+    command_param *ch = new command_param();
+    int success = command_handle(argc, argv, ch);
+    if (success == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    if (WORKLOAD && ((ch->queue && strcmp(ch->queue, "spsc") == 0) || (ch->stack && strcmp(ch->stack, "chase_lev") == 0))) {
+        cout << "--ops and --duration need a buffer every thread can push and pop (not spsc or chase_lev)" << endl;
+        return EXIT_FAILURE;
+    }
+
+    ofstream fptr_out;
+    if (!WORKLOAD) {
+        fptr_out.open(ch->out_file);
+        if (!fptr_out) {
+            cout << "Failed to open " << ch->out_file << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (ch->queue && strcmp(ch->queue, "spsc") == 0 && NUM_THREADS != 2) {
+        cout << "spsc runs one producer and one consumer, using 2 threads" << endl;
+        NUM_THREADS = 2;
+    }
+    threads.resize(NUM_THREADS);
+    // CPU of each thread (thread i gets entry i modulo the size), empty when placement is left to the scheduler
+    vector<int> cpus;
+    if (AFFINITY_POLICY == AFFINITY_COMPACT) {
+        cpus = affinity_compact();
+    } else if (AFFINITY_POLICY == AFFINITY_SCATTER) {
+        cpus = affinity_scatter();
+    } else if (AFFINITY_POLICY == AFFINITY_LIST) {
+        cpus = affinity_parse(AFFINITY_CPUS);
+    }
+    if (AFFINITY_POLICY != AFFINITY_NONE) {
+        if (cpus.empty()) {
+            cout << "No CPUs to pin the threads to, check --affinity" << endl;
+            return EXIT_FAILURE;
+        }
+        cout << "Affinity CPUs:";
+        for (unsigned i = 0; i < NUM_THREADS; i++) {
+            cout << (i ? "," : " ") << cpus[i % cpus.size()];
+        }
+        cout << endl;
+    }
+    // Read data from the input file into a vector
+    vector<int> input_data;
+    vector<int> output_data;
+    if (WORKLOAD) {
+        input_data = generate_keys(); // Synthetic workload: the threads draw their keys from this pool
+    } else {
+        loader_stats load;
+        if (!load_input(ch->source_file, input_data, &load)) { // Map the file and parse it in parallel chunks
+            return EXIT_FAILURE;
+        }
+        printf("Input: %zu entries (%s, %u chunks) in %.3lf ms\n", input_data.size(), load.binary ? "binary" : "text",
+               load.chunks, load.seconds * 1e3);
+        if (SAVE_BINARY) {
+            if (!save_input_binary(SAVE_BINARY, input_data)) {
+                return EXIT_FAILURE;
+            }
+            cout << "Wrote " << input_data.size() << " entries to " << SAVE_BINARY << endl;
+            return 0;
+        }
+    }
+    output_data.resize(input_data.size() + 10); // adding extra size of 10 to see the abnormalities of stack
+    fill(output_data.begin(), output_data.end(), 0); // Fill all elements with 0
+
+    unsigned buffer_type;
+    // Set buffer type based on command-line arguments (stack or queue)
+    if (ch->stack) {
+        buffer_type = STACK;
+    } else if (ch->queue) {
+        buffer_type = QUEUE;
+    } else if (ch->pq) {
+        buffer_type = PRIORITY;
+    } else {
+        buffer_type = STACK;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    unsigned long long start_ticks = latency_now();
+    for (unsigned i = 0; i < NUM_THREADS; i++) {
+    int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    // Handle different buffer configurations based on the command-line input
+    if ((ch->stack && strcmp(ch->stack, "sgl") == 0)) {
+          threads[i] = new thread(start_worker, insert_remove_sgl_stack, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    }else if ((ch->queue && strcmp(ch->queue, "sgl") == 0)) {
+          threads[i] = new thread(start_worker, insert_remove_sgl_queue, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "treiber") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_treiber, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "treiber_tagged") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_treiber_tagged, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "mns") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_mns, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "mns_elim") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_mns_elim, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "twolock") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_twolock, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "flat") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_queue_flat, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "faa") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_faa, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "ring") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_ring, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "spsc") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_spsc, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "dual") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_dual_stack, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "dual") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_dual_queue, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "multi") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_multi_stack, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->queue && strcmp(ch->queue, "multi") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_multi_queue, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->pq && strcmp(ch->pq, "skiplist") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_skiplist_pq, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "chase_lev") == 0)){
+          threads[i] = new thread(start_worker, insert_remove_work_stealing, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if((ch->stack && strcmp(ch->stack, "treiber_elim") == 0)){
+          //cout << "I am here"<< endl;
+          threads[i] = new thread(start_worker, insert_remove_treiber_elim, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if ((ch->stack && strcmp(ch->stack, "sgl_elim") == 0)) {
+         threads[i] = new thread(start_worker, insert_remove_sgl_elim, ref(input_data), ref(output_data), i, buffer_type, cpu);
+    } else if ((ch->stack && strcmp(ch->stack, "stack_flat") == 0)) {
+        threads[i] = new thread(start_worker, insert_remove_stack_flat, ref(input_data), ref(output_data), i, buffer_type, cpu);
+            
+    }
+    }
+
+    // Wait for all threads to finish
+    for (unsigned i = 0; i < NUM_THREADS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    unsigned long long end_ticks = latency_now();
+    unsigned long long elapsed_ns;
+    elapsed_ns = (endTime.tv_sec - startTime.tv_sec) * 1000000000 +      (endTime.tv_nsec - startTime.tv_nsec);
+    printf("Elapsed (ns): %llu\n", elapsed_ns);
+    double elapsed_s = ((double)elapsed_ns) / 1000000000.0;
+    printf("Elapsed (s): %lf\n", elapsed_s);
+    // Node allocations: with the pool, nodes only reach the heap when oversized; the heap sees slab refills instead
+    pool_stats allocs = pool_get_stats();
+    printf("Allocator: %s\n", pool_mode());
+    printf("Layout: %s (%zu-byte cache lines)\n", LAYOUT_NAME, CACHE_LINE_SIZE);
+    printf("Node allocations: pool %llu, heap %llu\n", allocs.pool_allocs, allocs.heap_allocs);
+    printf("Slab refills: %llu (%d KB each)\n", allocs.slab_refills, POOL_SLAB_SIZE / 1024);
+    // Elimination stacks: how many contended operations met a partner instead of retrying
+    elim_stats elim = elim_get_stats();
+    if (elim.attempts > 0) {
+        printf("Elimination: attempts %llu, hits %llu (%.1lf%%), too young %llu\n",
+               elim.attempts, elim.hits, 100.0 * elim.hits / elim.attempts, elim.young);
+    }
+#ifdef CONTENTION_STATS
+    // Contention counters (make STATS=on): why the containers retried
+    contention_stats cont = contention_get_stats();
+    static const char *cont_ops[] = {"push", "pop"};
+    for (int op = 0; op < CONTENTION_OPS; op++) {
+        if (cont.cas_attempts[op] > 0) {
+            printf("Contention %s: CAS attempts %llu, failures %llu (%.1lf%%)\n", cont_ops[op], cont.cas_attempts[op],
+                   cont.cas_failures[op], 100.0 * cont.cas_failures[op] / cont.cas_attempts[op]);
+        }
+    }
+    if (cont.lock_acquires > 0) {
+        printf("Contention locks: acquires %llu, spins %llu (%.2lf per acquire)\n",
+               cont.lock_acquires, cont.lock_spins, (double)cont.lock_spins / cont.lock_acquires);
+    }
+    for (int i = 0; i < ELIM_MAX_WIDTH; i++) {
+        if (cont.elim_attempts[i] > 0) {
+            printf("Contention elimination slot %d: attempts %llu, hits %llu, timeouts %llu\n",
+                   i, cont.elim_attempts[i], cont.elim_hits[i], cont.elim_timeouts[i]);
+        }
+    }
+    if (cont.combiner_sessions > 0) {
+        printf("Contention combiner: sessions %llu, passes %llu, requests %llu (%.2lf per pass, max %llu)\n",
+               cont.combiner_sessions, cont.combiner_passes, cont.combined_ops,
+               cont.combiner_passes ? (double)cont.combined_ops / cont.combiner_passes : 0.0, cont.max_batch);
+    }
+    printf("Contention empty pops: %llu\n", cont.empty_pops);
+#endif
+    // Blocking pops: how often a consumer slept and how often a push had to wake one
+    park_stats park = park_get_stats();
+    if (WAIT_TIMEOUT_US) {
+        printf("Parking: parks %llu, wakes %llu\n", park.parks, park.wakes);
+    }
+    // Work stealing: how often an idle thread found work in another thread's deque
+    if (ch->stack && strcmp(ch->stack, "chase_lev") == 0) {
+        ws_stats ws = ws_get_stats();
+        printf("Work stealing: attempts %llu, steals %llu\n", ws.attempts, ws.steals);
+    }
+    // Priority queue: every thread must have seen its own delete_min results in non-decreasing order
+    if (buffer_type == PRIORITY && !WORKLOAD) {
+        printf("Priority order: %u of %u threads non-decreasing\n", priority_sorted_threads(), NUM_THREADS);
+        // Conservation: the last round's delete_min results are exactly the input keys
+        vector<int> inserted(input_data);
+        vector<int> deleted(output_data.begin(), output_data.begin() + input_data.size());
+        sort(inserted.begin(), inserted.end());
+        sort(deleted.begin(), deleted.end());
+        printf("Conservation: %s\n", inserted == deleted ? "every key deleted once" : "FAILED, deleted keys differ from the input");
+    }
+    // Relaxed containers: how far the pops drifted from strict LIFO/FIFO order
+    if (RANK_ERROR && ((ch->stack && strcmp(ch->stack, "multi") == 0) || (ch->queue && strcmp(ch->queue, "multi") == 0))) {
+        rank_error_stats ranks = multi_rank_error(buffer_type);
+        printf("Rank error: mean %.2lf, max %llu over %llu pops\n", ranks.mean, ranks.max, ranks.pops);
+    }
+    if (LATENCY) {
+        // Latency histograms: ticks are converted with the tick rate measured over the run
+        static const char *op_names[] = {"push", "pop", "empty pop"};
+        double ns_per_tick = elapsed_ns / (double)(end_ticks - start_ticks);
+        for (int op = 0; op < LATENCY_OPS; op++) {
+            latency_stats lat = latency_get_stats(op);
+            printf("Latency %s (ns): p50 %.0lf, p90 %.0lf, p99 %.0lf, p99.9 %.0lf, max %.0lf over %llu calls\n",
+                   op_names[op], lat.p50 * ns_per_tick, lat.p90 * ns_per_tick, lat.p99 * ns_per_tick,
+                   lat.p999 * ns_per_tick, lat.max * ns_per_tick, lat.count);
+        }
+    }
+    if (WORKLOAD) {
+        // Synthetic workload: the aggregate rate divides every operation by the slowest thread's time
+        static const char *key_names[] = {"uniform", "zipf", "sequential"};
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        unsigned long long total_ops = 0;
+        double longest = 0.0;
+        printf("Workload: %s, mix %u%% push, %u producers, %u consumers, %s keys over %u, prefill %llu\n",
+               WORKLOAD_OPS ? "fixed ops" : "fixed duration", PUSH_PERCENT, PRODUCERS, CONSUMERS,
+               key_names[KEY_DIST], KEY_RANGE, PREFILL);
+        for (unsigned i = 0; i < NUM_THREADS; i++) {
+            workload_stats stats = workload_thread_stats(i);
+            const char *role = i < PRODUCERS ? "producer" : i < PRODUCERS + CONSUMERS ? "consumer" : "mixed";
+            printf("Thread %u (%s): ops %llu, pushes %llu, pops %llu (empty %llu), ops/s %.0lf\n",
+                   i, role, stats.ops, stats.pushes, stats.pops, stats.empty,
+                   stats.seconds > 0 ? stats.ops / stats.seconds : 0.0);
+            total_ops += stats.ops;
+            longest = max(longest, stats.seconds);
+        }
+        printf("Operations: %llu\n", total_ops);
+        printf("Throughput (ops/s): %.0lf\n", longest > 0 ? total_ops / longest : 0.0);
+        printf("Peak RSS (KB): %ld\n", usage.ru_maxrss);
+    } else if (BENCH_ROUNDS > 1) {
+        // Benchmark mode: every element is pushed and popped once per round
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double ops = 2.0 * input_data.size() * BENCH_ROUNDS;
+        printf("Throughput (ops/s): %.0lf\n", ops / elapsed_s);
+        printf("Peak RSS (KB): %ld\n", usage.ru_maxrss);
+    }
+    if (!WORKLOAD) {
+        // Write the sorted data to the output file
+        for (auto i = output_data.begin(); i < output_data.end(); ++i) {
+            fptr_out << *i << "\n";
+        }
+        fptr_out.close();
+    }
+
+    cout << "Done!!!" << endl;
+
+    return 0;
+}
+
@@ -0,0 +1,75 @@
+#include "latency.hpp"
+#include <atomic>
+
+using namespace std;
+
+static atomic<unsigned long long> total_buckets[LATENCY_OPS][LATENCY_BUCKETS];  // Histograms of the exited threads
+static atomic<unsigned long long> total_max[LATENCY_OPS];                       // Largest sample of the exited threads
+
+// Per-thread histograms, added to the totals when the thread exits. They are allocated by the thread itself on
+// first use rather than living in its TLS block, which the parent zeroes (first touch on the parent's CPU).
+struct latency_thread_state {
+    latency_histogram *hist = nullptr;  // Allocated by latency_thread_histogram
+
+    ~latency_thread_state();
+};
+
+static thread_local latency_thread_state latency_local;
+
+// Largest sample that falls into a bucket
+static unsigned long long latency_bucket_limit(int bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+    unsigned long long lower = (unsigned long long)(LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << shift;
+    return lower + (1ull << shift) - 1;
+}
+
+latency_thread_state::~latency_thread_state() {
+    if (!hist) {
+        return;
+    }
+    for (int op = 0; op < LATENCY_OPS; op++) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            if (hist->buckets[op][i]) {
+                total_buckets[op][i].fetch_add(hist->buckets[op][i], memory_order_relaxed);
+            }
+        }
+        unsigned long long seen = total_max[op].load(memory_order_relaxed);
+        while (seen < hist->max[op] && !total_max[op].compare_exchange_weak(seen, hist->max[op], memory_order_relaxed));
+    }
+    delete hist;
+}
+
+latency_histogram *latency_thread_histogram() {
+    if (!latency_local.hist) {
+        latency_local.hist = new latency_histogram();
+    }
+    return latency_local.hist;
+}
+
+latency_stats latency_get_stats(int op) {
+    static unsigned long long merged[LATENCY_BUCKETS];
+    static const latency_histogram none;
+    const latency_histogram &own = latency_local.hist ? *latency_local.hist : none;  // The caller's histograms
+    unsigned long long count = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        merged[i] = total_buckets[op][i].load(memory_order_relaxed) + own.buckets[op][i];
+        count += merged[i];
+    }
+    latency_stats stats = {count, 0, 0, 0, 0, max(total_max[op].load(memory_order_relaxed), own.max[op])};
+
+    // Walk the buckets once, filling each percentile when the running count first reaches its rank
+    const double fractions[] = {0.5, 0.9, 0.99, 0.999};
+    unsigned long long *results[] = {&stats.p50, &stats.p90, &stats.p99, &stats.p999};
+    unsigned long long seen = 0;
+    int next = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && next < 4 && count > 0; i++) {
+        seen += merged[i];
+        while (next < 4 && seen >= fractions[next] * count) {
+            *results[next++] = min(latency_bucket_limit(i), stats.max);
+        }
+    }
+    return stats;
+}
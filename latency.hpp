@@ -0,0 +1,70 @@
+// Per-operation latency histograms (--latency) for the push and pop calls of the drivers.
+//
+// Every call is timed with the time stamp counter and counted in a log-linear histogram (HDR-style): values
+// below LATENCY_SUB_BUCKETS cycles get a bucket each, larger ones are bucketed by their leading bit and the
+// LATENCY_SUB_BITS bits below it, so a bucket is never wider than 1/16 of its lower bound. Each thread counts
+// into its own thread_local histograms (no shared writes on the hot path) and adds them to the global ones
+// when it exits. main converts cycles to nanoseconds with the tick rate measured over the whole run.
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+#define LATENCY_SUB_BITS    (4)                            // Bits of precision below the leading bit
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)        // Buckets per power of two
+#define LATENCY_BUCKETS     (61 * LATENCY_SUB_BUCKETS)     // Enough for any 64-bit cycle count
+
+// Operations with a histogram each
+#define LATENCY_PUSH  (0)  // push / insert / try_push
+#define LATENCY_POP   (1)  // pop / remove / delete_min / pop_wait_for that returned an element
+#define LATENCY_EMPTY (2)  // The same calls when they found the buffer empty (cheap, kept apart so they do not hide real pops)
+#define LATENCY_OPS   (3)
+
+// Timestamp in ticks: rdtsc on x86 (no fence, the few cycles of reordering do not matter at the tail),
+// the steady clock in nanoseconds elsewhere
+inline unsigned long long latency_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// One thread's histograms; record() is the whole hot path
+struct latency_histogram {
+    unsigned long long buckets[LATENCY_OPS][LATENCY_BUCKETS] = {};
+    unsigned long long max[LATENCY_OPS] = {};
+
+    // Bucket of a sample: exact below LATENCY_SUB_BUCKETS, then LATENCY_SUB_BUCKETS buckets per power of two
+    static int bucket(unsigned long long ticks) {
+        if (ticks < LATENCY_SUB_BUCKETS) {
+            return ticks;
+        }
+        int msb = 63 - __builtin_clzll(ticks);
+        int sub = (ticks >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+        return (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+    }
+
+    void record(int op, unsigned long long ticks) {
+        buckets[op][bucket(ticks)]++;
+        if (ticks > max[op]) {
+            max[op] = ticks;
+        }
+    }
+};
+
+// Summary of one operation's histogram, in ticks
+struct latency_stats {
+    unsigned long long count;  // Calls recorded
+    unsigned long long p50;    // Upper bound of the bucket holding the percentile
+    unsigned long long p90;
+    unsigned long long p99;
+    unsigned long long p999;
+    unsigned long long max;    // Exact largest sample
+};
+
+latency_histogram *latency_thread_histogram();  // Calling thread's histograms, merged into the totals when it exits
+latency_stats latency_get_stats(int op);        // Merged histogram of the exited threads plus the caller
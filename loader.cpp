@@ -0,0 +1,239 @@
+#include "loader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define LOADER_SIMD_DIGITS (9)    // Longest digit run converted with SSE2 (always fits an int)
+#define LOADER_LINE_COPY   (64)   // Lines shorter than this are copied to the stack for the atoi fallback
+
+// Bounds of the mapped file, for the 16-byte loads that must not leave it
+struct loader_map {
+    const char *begin;
+    const char *end;
+};
+
+// Number of '\n' in [pos, end)
+static size_t count_newlines(const char *pos, const char *end) {
+    size_t count = 0;
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, newline)));
+    }
+#endif
+    for (; pos < end; pos++) {
+        count += *pos == '\n';
+    }
+    return count;
+}
+
+#if defined(__SSE2__)
+// Length of the run of decimal digits at pos (at most 16); the 16 bytes at pos must be readable
+static int digit_run_sse2(const char *pos) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    return __builtin_ctz(~_mm_movemask_epi8(digit) | 0x10000);
+}
+
+// Value of the len (1 .. 16) digits ending just before end; the 16 bytes before end must be readable.
+// The digits are right-aligned in one register, then combined pairwise: 2-digit, 4-digit, 8-digit halves.
+static unsigned long long digits_value_sse2(const char *end, int len) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(end - 16));
+    __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i keep = _mm_cmpgt_epi8(index, _mm_set1_epi8(15 - len));  // Only the last len bytes are digits
+    __m128i digits = _mm_and_si128(_mm_sub_epi8(chars, _mm_set1_epi8('0')), keep);
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i tens = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+    __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(digits, zero), tens),
+                                    _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero), tens));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    quads = _mm_packs_epi32(quads, quads);
+    __m128i halves = _mm_madd_epi16(quads, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    unsigned long long high = (unsigned)_mm_cvtsi128_si32(halves);                      // Digits 0 .. 7
+    unsigned long long low = (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(halves, 4));    // Digits 8 .. 15
+    return high * 100000000ull + low;
+}
+#endif
+
+// Parse the line at pos like atoi on the line read by getline; returns the start of the next line
+static const char *parse_line(const char *pos, const char *end, const loader_map &map, int &value) {
+#if defined(__SSE2__)
+    // Fast path: an optional '-' and up to LOADER_SIMD_DIGITS digits, away from the edges of the mapping
+    bool negative = *pos == '-';
+    const char *digits = pos + negative;
+    if (digits >= map.begin + 16 && digits + 16 <= map.end) {
+        int len = digit_run_sse2(digits);
+        if (len > 0 && len <= LOADER_SIMD_DIGITS && digits + len <= end) {
+            int number = digits_value_sse2(digits + len, len);
+            value = negative ? -number : number;
+            const char *next = digits + len;
+            if (next < end && *next == '\n') {
+                return next + 1;
+            }
+            const char *newline = static_cast<const char *>(memchr(next, '\n', end - next));
+            return newline ? newline + 1 : end;
+        }
+    }
+#endif
+    // Anything else (leading spaces, '+', long numbers, text): atoi on a NUL-terminated copy of the line
+    const char *newline = static_cast<const char *>(memchr(pos, '\n', end - pos));
+    const char *line_end = newline ? newline : end;
+    size_t length = line_end - pos;
+    if (length < LOADER_LINE_COPY) {
+        char line[LOADER_LINE_COPY];
+        memcpy(line, pos, length);
+        line[length] = '\0';
+        value = atoi(line);
+    } else {
+        value = atoi(string(pos, length).c_str());
+    }
+    return newline ? newline + 1 : end;
+}
+
+// Start of the first line that begins at or after pos
+static const char *line_start(const char *pos, const char *begin, const char *end) {
+    if (pos <= begin) {
+        return begin;
+    }
+    const char *newline = static_cast<const char *>(memchr(pos - 1, '\n', end - (pos - 1)));
+    return newline ? newline + 1 : end;
+}
+
+// Run work(chunk) for every chunk, on its own thread when there is more than one
+template <typename Work>
+static void for_each_chunk(unsigned chunks, Work work) {
+    vector<thread> workers;
+    for (unsigned chunk = 1; chunk < chunks; chunk++) {
+        workers.emplace_back(work, chunk);
+    }
+    work(0);
+    for (thread &worker : workers) {
+        worker.join();
+    }
+}
+
+static void load_text(const loader_map &map, vector<int> &data, unsigned chunks) {
+    size_t size = map.end - map.begin;
+    vector<const char *> starts(chunks + 1);
+    for (unsigned chunk = 0; chunk < chunks; chunk++) {
+        starts[chunk] = line_start(map.begin + size * chunk / chunks, map.begin, map.end);
+    }
+    starts[chunks] = map.end;
+
+    // Pass 1: lines per chunk; a last line without '\n' still counts, as it does for getline
+    vector<size_t> offsets(chunks + 1, 0);
+    for_each_chunk(chunks, [&](unsigned chunk) {
+        offsets[chunk + 1] = count_newlines(starts[chunk], starts[chunk + 1]);
+    });
+    if (map.end[-1] != '\n') {
+        offsets[chunks]++;
+    }
+    for (unsigned chunk = 0; chunk < chunks; chunk++) {
+        offsets[chunk + 1] += offsets[chunk];
+    }
+
+    // Pass 2: every chunk parses into its own range of the vector
+    data.resize(offsets[chunks]);
+    for_each_chunk(chunks, [&](unsigned chunk) {
+        int *out = data.data() + offsets[chunk];
+        for (const char *pos = starts[chunk]; pos < starts[chunk + 1]; ) {
+            pos = parse_line(pos, starts[chunk + 1], map, *out++);
+        }
+    });
+}
+
+static bool load_binary(const char *path, const loader_map &map, vector<int> &data, unsigned chunks) {
+    loader_header header;
+    memcpy(&header, map.begin, sizeof(header));
+    size_t available = (map.end - map.begin - sizeof(header)) / sizeof(int);
+    if (header.count > available) {
+        cout << path << " is truncated: header says " << header.count << " entries, file holds " << available << endl;
+        return false;
+    }
+    const int *values = reinterpret_cast<const int *>(map.begin + sizeof(header));
+    data.resize(header.count);
+    for_each_chunk(chunks, [&](unsigned chunk) {
+        size_t first = header.count * chunk / chunks;
+        size_t last = header.count * (chunk + 1) / chunks;
+        memcpy(data.data() + first, values + first, (last - first) * sizeof(int));
+    });
+    return true;
+}
+
+bool load_input(const char *path, vector<int> &data, loader_stats *stats) {
+    auto start = chrono::steady_clock::now();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        cout << "Failed to open " << path << endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        cout << "Failed to stat " << path << endl;
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    data.clear();
+    loader_stats result = {false, 0, 0.0};
+    bool loaded = true;
+    if (size > 0) {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            cout << "Failed to map " << path << endl;
+            close(fd);
+            return false;
+        }
+        madvise(mapping, size, MADV_WILLNEED);
+        loader_map map = {static_cast<const char *>(mapping), static_cast<const char *>(mapping) + size};
+
+        unsigned cpus = max(1u, thread::hardware_concurrency());
+        result.chunks = max<size_t>(1, min<size_t>(cpus, size / LOADER_MIN_CHUNK));
+        result.binary = size >= sizeof(loader_header) && memcmp(map.begin, LOADER_MAGIC, 8) == 0;
+        if (result.binary) {
+            loaded = load_binary(path, map, data, result.chunks);
+        } else {
+            load_text(map, data, result.chunks);
+        }
+        munmap(mapping, size);
+    }
+    close(fd);
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (stats) {
+        *stats = result;
+    }
+    return loaded;
+}
+
+bool save_input_binary(const char *path, const vector<int> &data) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        cout << "Failed to open " << path << endl;
+        return false;
+    }
+    loader_header header;
+    memcpy(header.magic, LOADER_MAGIC, 8);
+    header.count = data.size();
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(data.data(), sizeof(int), data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        cout << "Failed to write " << path << endl;
+    }
+    return written;
+}
@@ -0,0 +1,187 @@
+#include "buffer.hpp"
+#include <thread>
+
+// Pause between polls, and give the CPU away every LOCK_YIELD_INTERVAL polls so a waiter does not burn
+// its whole time slice when the thread it waits for is not running
+static void lock_relax(unsigned &spins) {
+    CONTENTION_COUNT(lock_spins);
+    if (++spins % LOCK_YIELD_INTERVAL == 0) {
+        this_thread::yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+// A successful try_lock counts as an acquisition (contention counters only)
+#define TRY_LOCKED(taken) ((taken) ? (CONTENTION_COUNT(lock_acquires), true) : false)
+
+/************************************ TAS ************************************/
+
+void tas_lock::lock(node &n) {
+    CONTENTION_COUNT(lock_acquires);
+    while (!cas(flag, false, true, ACQ_REL)) {
+        CONTENTION_COUNT(lock_spins);
+    }
+}
+
+bool tas_lock::try_lock(node &n) {
+    return TRY_LOCKED(!flag.load(RELAXED) && cas(flag, false, true, ACQ_REL));
+}
+
+void tas_lock::unlock(node &n) {
+    flag.store(false, REL);
+}
+
+
+/*************************** TTAS with exponential backoff ***************************/
+
+void ttas_lock::lock(node &n) {
+    CONTENTION_COUNT(lock_acquires);
+    unsigned backoff = TTAS_BACKOFF_MIN;
+    unsigned spins = 0;
+    while (true) {
+        while (flag.load(RELAXED)) {
+            lock_relax(spins);  // Spin in the local cache until the holder releases the line
+        }
+        if (!flag.exchange(true, ACQ)) {
+            return;
+        }
+        for (unsigned i = 0; i < backoff; i++) {
+            cpu_relax();  // Lost the race: back off before looking again
+        }
+        backoff = min(backoff * 2, (unsigned)TTAS_BACKOFF_MAX);
+    }
+}
+
+bool ttas_lock::try_lock(node &n) {
+    return TRY_LOCKED(!flag.load(RELAXED) && !flag.exchange(true, ACQ));
+}
+
+void ttas_lock::unlock(node &n) {
+    flag.store(false, REL);
+}
+
+
+/*********************************** Ticket ***********************************/
+
+void ticket_lock::lock(node &n) {
+    CONTENTION_COUNT(lock_acquires);
+    unsigned ticket = next_ticket.fetch_add(1, RELAXED);
+    unsigned spins = 0;
+    while (now_serving.load(ACQ) != ticket) {
+        lock_relax(spins);
+    }
+}
+
+bool ticket_lock::try_lock(node &n) {
+    unsigned serving = now_serving.load(ACQ);
+    return TRY_LOCKED(next_ticket.load(RELAXED) == serving && cas(next_ticket, serving, serving + 1, ACQ));
+}
+
+void ticket_lock::unlock(node &n) {
+    // Only the holder writes now_serving, so a load and a store are enough
+    now_serving.store(now_serving.load(RELAXED) + 1, REL);
+}
+
+
+/************************************ MCS ************************************/
+
+void mcs_lock::lock(node &n) {
+    CONTENTION_COUNT(lock_acquires);
+    n.next.store(nullptr, RELAXED);
+    n.locked.store(true, RELAXED);
+    node *pred = tail.exchange(&n, ACQ_REL);
+    if (pred) {
+        pred->next.store(&n, REL);  // Let the predecessor find us when it releases
+        unsigned spins = 0;
+        while (n.locked.load(ACQ)) {
+            lock_relax(spins);      // Spin on our own node only
+        }
+    }
+}
+
+bool mcs_lock::try_lock(node &n) {
+    n.next.store(nullptr, RELAXED);
+    n.locked.store(false, RELAXED);
+    return TRY_LOCKED(!tail.load(RELAXED) && cas(tail, (node *)nullptr, &n, ACQ_REL));
+}
+
+void mcs_lock::unlock(node &n) {
+    node *succ = n.next.load(ACQ);
+    if (!succ) {
+        if (cas(tail, &n, (node *)nullptr, ACQ_REL)) {
+            return;  // No waiter
+        }
+        // A waiter swapped itself into the tail but has not linked itself yet
+        unsigned spins = 0;
+        while (!(succ = n.next.load(ACQ))) {
+            lock_relax(spins);
+        }
+    }
+    succ->locked.store(false, REL);  // Hand the lock over
+}
+
+
+/************************************ CLH ************************************/
+
+// Spare node of the calling thread: the predecessor node recycled by its last unlock
+struct clh_thread_cache {
+    clh_qnode *spare = nullptr;
+
+    ~clh_thread_cache() { delete spare; }
+};
+
+static thread_local clh_thread_cache clh_local;
+
+static clh_qnode *clh_take() {
+    clh_qnode *qnode = clh_local.spare;
+    if (!qnode) {
+        return new clh_qnode();
+    }
+    clh_local.spare = nullptr;
+    return qnode;
+}
+
+static void clh_give(clh_qnode *qnode) {
+    if (clh_local.spare) {
+        delete qnode;  // Already holding a spare (e.g. the thread held two CLH locks at once)
+    } else {
+        clh_local.spare = qnode;
+    }
+}
+
+void clh_lock::lock(node &n) {
+    CONTENTION_COUNT(lock_acquires);
+    n.mine = clh_take();
+    n.mine->locked.store(true, RELAXED);
+    n.pred = tail.exchange(n.mine, ACQ_REL);
+    unsigned spins = 0;
+    while (n.pred->locked.load(ACQ)) {
+        lock_relax(spins);  // Spin on the predecessor's node only
+    }
+}
+
+bool clh_lock::try_lock(node &n) {
+    clh_qnode *pred = tail.load(ACQ);
+    if (pred->locked.load(ACQ)) {
+        return false;  // Held or waited for
+    }
+    n.mine = clh_take();
+    n.mine->locked.store(true, RELAXED);
+    if (!cas(tail, pred, n.mine, ACQ_REL)) {
+        clh_give(n.mine);
+        return false;
+    }
+    // pred may have been recycled and enqueued again since it was checked, so wait on it like lock() does
+    n.pred = pred;
+    unsigned spins = 0;
+    while (n.pred->locked.load(ACQ)) {
+        lock_relax(spins);
+    }
+    return TRY_LOCKED(true);
+}
+
+void clh_lock::unlock(node &n) {
+    n.mine->locked.store(false, REL);  // The successor (or the next locker) now owns mine
+    clh_give(n.pred);                  // Nobody else references the predecessor's node any more
+}
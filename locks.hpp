@@ -0,0 +1,103 @@
+// Lock policies for the lock-based containers (stack, queue, stack_elim, stack_flat and queue_flat).
+// Included from buffer.hpp after the memory order macros, cas(), cpu_relax() and CACHE_ALIGNED, which it relies on.
+//
+// Every policy exposes the same interface so the containers can take it as a template parameter:
+//   - `typename Lock::node n;` per-acquisition state, owned by the caller until unlock(n) returns
+//   - `l.lock(n)` spins until the lock is held
+//   - `l.try_lock(n)` takes the lock only if nobody holds it or waits for it; returns true on success
+//   - `l.unlock(n)` releases a lock taken with the same node
+// A queue lock (MCS, CLH) links the node into its wait queue, so each waiter spins on its own cache line.
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+#define TTAS_BACKOFF_MIN (4)     // First backoff of the TTAS lock after a lost test-and-set, in pause iterations
+#define TTAS_BACKOFF_MAX (1024)  // Longest backoff of the TTAS lock, in pause iterations
+#define LOCK_YIELD_INTERVAL (128)    // Polls of a waiting thread between yields (the holder may be descheduled)
+
+// Test-and-set: every waiter CASes the flag in a loop (the original lock of the SGL containers)
+class tas_lock {
+    public:
+        struct node {};
+
+        CACHE_ALIGNED atomic<bool> flag;  // Set while the lock is held
+
+        tas_lock() : flag(false) {}
+        void lock(node &n);
+        bool try_lock(node &n);
+        void unlock(node &n);
+};
+
+// Test-and-test-and-set with exponential backoff: waiters read the flag (a shared line, no RMW) until it
+// looks free, then try one exchange; a lost race doubles the pause before the next attempt
+class ttas_lock {
+    public:
+        struct node {};
+
+        CACHE_ALIGNED atomic<bool> flag;  // Set while the lock is held
+
+        ttas_lock() : flag(false) {}
+        void lock(node &n);
+        bool try_lock(node &n);
+        void unlock(node &n);
+};
+
+// Ticket lock: FIFO order; a waiter takes a ticket with one fetch_add and waits until it is served
+class ticket_lock {
+    public:
+        struct node {};
+
+        CACHE_ALIGNED atomic<unsigned> next_ticket;  // Next ticket to hand out
+        CACHE_ALIGNED atomic<unsigned> now_serving;  // Ticket of the holder
+
+        ticket_lock() : next_ticket(0), now_serving(0) {}
+        void lock(node &n);
+        bool try_lock(node &n);
+        void unlock(node &n);
+};
+
+// MCS queue lock (Mellor-Crummey, Scott 1991): the node lives on the caller's stack; a waiter appends it to
+// the queue and spins on its own locked flag until its predecessor hands the lock over
+class mcs_lock {
+    public:
+        struct node {
+            CACHE_ALIGNED atomic<node *> next;  // Successor in the wait queue
+            atomic<bool> locked;                // True while the owner has to wait
+
+            node() : next(nullptr), locked(false) {}
+        };
+
+        CACHE_ALIGNED atomic<node *> tail;  // Last node of the wait queue, nullptr when the lock is free
+
+        mcs_lock() : tail(nullptr) {}
+        void lock(node &n);
+        bool try_lock(node &n);
+        void unlock(node &n);
+};
+
+// Queue node of the CLH lock: outlives the acquisition that enqueued it, so it is heap allocated and recycled
+struct clh_qnode {
+    CACHE_ALIGNED atomic<bool> locked;  // True while the owner holds or waits for the lock
+
+    clh_qnode() : locked(false) {}
+};
+
+// CLH queue lock (Craig; Landin, Hagersten): a waiter swaps its node into the tail and spins on the locked flag of
+// its predecessor's node. On release the thread keeps the predecessor's node for its next acquisition.
+class clh_lock {
+    public:
+        struct node {
+            clh_qnode *mine = nullptr;  // Node enqueued by this acquisition
+            clh_qnode *pred = nullptr;  // Node of the predecessor, recycled on unlock
+        };
+
+        CACHE_ALIGNED atomic<clh_qnode *> tail;  // Last node of the queue (an unlocked node when the lock is free)
+
+        clh_lock() : tail(new clh_qnode()) {}
+        ~clh_lock() { delete tail.load(RELAXED); }
+        void lock(node &n);
+        bool try_lock(node &n);
+        void unlock(node &n);
+};
@@ -0,0 +1,188 @@
+#include "buffer.hpp"
+#include <new>
+
+// Free block: next links blocks of a thread cache or a batch, next_batch links batches on the global list
+struct pool_block {
+    pool_block *next;
+    pool_block *next_batch;
+};
+
+// Thread cache for one size class (trivially destructible so it stays usable during thread exit)
+struct pool_cache {
+    pool_block *head;  // First free block
+    unsigned count;    // Number of free blocks
+};
+
+// Global list of batches for one size class
+struct pool_class {
+    atomic<bool> lock;     // Spin lock, only taken once per POOL_BATCH allocations or frees
+    pool_block *batches;   // Stack of batches
+};
+
+static pool_class pool_classes[POOL_NUM_CLASSES];
+
+static atomic<unsigned long long> total_pool_allocs(0);
+static atomic<unsigned long long> total_heap_allocs(0);
+static atomic<unsigned long long> total_slab_refills(0);
+static atomic<unsigned long long> total_frees(0);
+
+static thread_local pool_cache pool_caches[POOL_NUM_CLASSES];
+static thread_local pool_stats pool_local_stats;
+static thread_local bool pool_thread_exited = false;
+
+// Returns the thread caches and counters to the global state when the thread exits
+struct pool_flusher {
+    bool registered = false;
+    ~pool_flusher();
+};
+
+static thread_local pool_flusher pool_thread_flusher;
+
+static void push_batch(int size_class, pool_block *batch) {
+    pool_class &global = pool_classes[size_class];
+    while (!cas(global.lock, false, true, ACQ_REL));
+    batch->next_batch = global.batches;
+    global.batches = batch;
+    global.lock.store(false, REL);
+}
+
+#ifndef NODE_POOL_HEAP
+static pool_block *pop_batch(int size_class) {
+    pool_class &global = pool_classes[size_class];
+    while (!cas(global.lock, false, true, ACQ_REL));
+    pool_block *batch = global.batches;
+    if (batch) {
+        global.batches = batch->next_batch;
+    }
+    global.lock.store(false, REL);
+    return batch;
+}
+
+// Refill an empty thread cache with a batch from the global list, or carve a new slab
+static void pool_refill(int size_class, pool_cache &cache) {
+    pool_thread_flusher.registered = true;  // First use constructs the flusher so it runs at thread exit
+
+    pool_block *batch = pop_batch(size_class);
+    if (batch) {
+        unsigned count = 0;
+        for (pool_block *block = batch; block; block = block->next) {
+            count++;
+        }
+        cache.head = batch;
+        cache.count = count;
+        return;
+    }
+
+    size_t block_size = (size_class + 1) * POOL_CLASS_SIZE;
+    size_t blocks = POOL_SLAB_SIZE / block_size;
+    char *slab = static_cast<char *>(::operator new(POOL_SLAB_SIZE));
+    pool_local_stats.slab_refills++;
+    for (size_t i = 0; i < blocks; i++) {
+        pool_block *block = reinterpret_cast<pool_block *>(slab + i * block_size);
+        block->next = (i + 1 < blocks) ? reinterpret_cast<pool_block *>(slab + (i + 1) * block_size) : nullptr;
+    }
+    cache.head = reinterpret_cast<pool_block *>(slab);
+    cache.count = blocks;
+}
+#endif
+
+pool_flusher::~pool_flusher() {
+    for (int i = 0; i < POOL_NUM_CLASSES; i++) {
+        if (pool_caches[i].head) {
+            push_batch(i, pool_caches[i].head);
+            pool_caches[i].head = nullptr;
+            pool_caches[i].count = 0;
+        }
+    }
+    total_pool_allocs.fetch_add(pool_local_stats.pool_allocs, RELAXED);
+    total_heap_allocs.fetch_add(pool_local_stats.heap_allocs, RELAXED);
+    total_slab_refills.fetch_add(pool_local_stats.slab_refills, RELAXED);
+    total_frees.fetch_add(pool_local_stats.frees, RELAXED);
+    pool_local_stats = {0, 0, 0, 0};
+    pool_thread_exited = true;  // Frees issued by later thread_local destructors go straight to the global list
+}
+
+void *pool_allocate(size_t size) {
+#ifndef NODE_POOL_HEAP
+    if (size <= POOL_CLASS_SIZE * POOL_NUM_CLASSES) {
+        int size_class = (size - 1) / POOL_CLASS_SIZE;
+        pool_cache &cache = pool_caches[size_class];
+        if (!cache.head) {
+            pool_refill(size_class, cache);
+        }
+        pool_block *block = cache.head;
+        cache.head = block->next;
+        cache.count--;
+        pool_local_stats.pool_allocs++;
+        return block;
+    }
+#endif
+    if (pool_local_stats.heap_allocs++ == 0 && !pool_thread_exited) {
+        pool_thread_flusher.registered = true;  // Make sure the counters are flushed at thread exit
+    }
+    return ::operator new(size);
+}
+
+void pool_free(void *ptr, size_t size) {
+    if (pool_local_stats.frees++ == 0 && !pool_thread_exited) {
+        pool_thread_flusher.registered = true;  // Make sure the counters are flushed at thread exit
+    }
+#ifndef NODE_POOL_HEAP
+    if (size <= POOL_CLASS_SIZE * POOL_NUM_CLASSES) {
+        int size_class = (size - 1) / POOL_CLASS_SIZE;
+        pool_block *block = static_cast<pool_block *>(ptr);
+        if (pool_thread_exited) {
+            block->next = nullptr;
+            push_batch(size_class, block);
+            return;
+        }
+        pool_cache &cache = pool_caches[size_class];
+        block->next = cache.head;
+        cache.head = block;
+        if (++cache.count >= 2 * POOL_BATCH) {
+            // Hand the first POOL_BATCH blocks back to the global list as one batch
+            pool_block *last = cache.head;
+            for (int i = 1; i < POOL_BATCH; i++) {
+                last = last->next;
+            }
+            pool_block *batch = cache.head;
+            cache.head = last->next;
+            last->next = nullptr;
+            cache.count -= POOL_BATCH;
+            push_batch(size_class, batch);
+        }
+        return;
+    }
+#endif
+    ::operator delete(ptr);
+}
+
+// A fresh slab is carved, and so first touched, by the thread that will allocate from it
+void pool_warm(size_t size) {
+#ifndef NODE_POOL_HEAP
+    if (size <= POOL_CLASS_SIZE * POOL_NUM_CLASSES) {
+        int size_class = (size - 1) / POOL_CLASS_SIZE;
+        pool_cache &cache = pool_caches[size_class];
+        if (!cache.head) {
+            pool_refill(size_class, cache);
+        }
+    }
+#endif
+}
+
+pool_stats pool_get_stats() {
+    pool_stats stats;
+    stats.pool_allocs = total_pool_allocs.load(RELAXED) + pool_local_stats.pool_allocs;
+    stats.heap_allocs = total_heap_allocs.load(RELAXED) + pool_local_stats.heap_allocs;
+    stats.slab_refills = total_slab_refills.load(RELAXED) + pool_local_stats.slab_refills;
+    stats.frees = total_frees.load(RELAXED) + pool_local_stats.frees;
+    return stats;
+}
+
+const char *pool_mode() {
+#ifdef NODE_POOL_HEAP
+    return "heap";
+#else
+    return "pool";
+#endif
+}
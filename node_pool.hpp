@@ -0,0 +1,28 @@
+// Per-thread node pool used by every container node (see node::operator new in buffer.hpp).
+//
+// Each thread keeps a free list per size class, so the hot path of a push or pop never takes a lock
+// or calls malloc. Free lists that grow past 2 * POOL_BATCH hand POOL_BATCH blocks back to a global
+// list in one step, and an empty thread cache takes a whole batch from it (or carves a new slab).
+// Building with `make ALLOC=heap` (-DNODE_POOL_HEAP) sends every node to the global heap instead.
+#pragma once
+
+#include <cstddef>
+
+#define POOL_CLASS_SIZE  (16)          // Granularity of the size classes in bytes
+#define POOL_NUM_CLASSES (16)          // Size classes served by the pool (16 .. 256 bytes)
+#define POOL_BATCH       (64)          // Blocks moved between a thread cache and the global list at once
+#define POOL_SLAB_SIZE   (64 * 1024)   // Bytes requested from the heap when a size class runs dry
+
+// Allocation counters, summed over all threads that have exited plus the calling thread
+struct pool_stats {
+    unsigned long long pool_allocs;  // Allocations served by a thread cache
+    unsigned long long heap_allocs;  // Nodes allocated on the global heap (oversized nodes or ALLOC=heap)
+    unsigned long long slab_refills; // Slabs of POOL_SLAB_SIZE bytes carved from the heap for the pool
+    unsigned long long frees;        // Nodes handed back
+};
+
+void *pool_allocate(size_t size);         // Allocate a block of at least size bytes
+void pool_free(void *ptr, size_t size);   // Return a block obtained from pool_allocate with the same size
+void pool_warm(size_t size);              // Fill the calling thread's cache for size now (first touch on its CPU)
+pool_stats pool_get_stats();              // Read the allocation counters
+const char *pool_mode();                  // "pool" or "heap", depending on the build
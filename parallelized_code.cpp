@@ -1,324 +1,914 @@
-#include "parallelized_code.hpp"
-#include "buffer.hpp"
-#include <mutex>
-#include <iostream>
-
-
-template <typename T>
-T fai(atomic<T> &status, T amount, memory_order mem_order) {
-    // Atomically add 'amount' to 'status' and return the previous value
-    return status.fetch_add(amount, mem_order);
-}
-
-// Global stack and queue buffers for storing data
-stack stack_buffer;
-queue queue_buffer;
-
-treiber_stack trieber_stack_buffer;
-mns_queue mns_queue_buffer;
-
-treiber_stack_elim treiber_stack_elim_buffer(8);
-
-stack_elim stack_elim_buffer(8);
-
-stack_flat stack_flat_buffer(8);
-
-atomic<int> input_index = 0;
-atomic<int> output_index = 0;
-
-// Atomic flag to indicate whether the file reading is complete
-atomic<bool> read_complete = false;
-
-void insert_remove_sgl_stack(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type)  {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif
-
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            stack_buffer.push(input_data[push_index]); // Push the element to the stack
-        }
-
-        // Try to pop an element from the stack
-        int element;
-        if (stack_buffer.pop(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-        }else{
-            pop_index = output_index;
-        }
-        //cout << "Thread ID: " << thread_id << endl;
-        // Check for boundary condition: input exhausted and stack empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-
-void insert_remove_sgl_queue(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type) {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            queue_buffer.insert(input_data[push_index]);
-        }
-        // Try to pop an element from the stack
-        int element;
-        if (queue_buffer.remove(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-        }else{
-            pop_index = output_index;
-        }
-        //cout << "Thread ID: " << thread_id << endl;
-        // Check for boundary condition: input exhausted and queue empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-void insert_remove_treiber(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type)  {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            trieber_stack_buffer.push(input_data[push_index]);
-        }
-        // Try to pop an element from the stack
-        int element;
-        if (trieber_stack_buffer.pop(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-        }else{
-            pop_index = output_index;
-        }
-        //cout << "Thread ID: " << thread_id << endl;
-        // Check for boundary condition: input exhausted and queue empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-/**
- * Function to insert elements into a lock-free MNS queue in a thread-safe manner.
- * 
- * @param fptr_src - Input file stream containing elements to insert
- * @param thread_id - ID of the thread performing the operation (for debugging/logging)
- * @param buffer_type - Specifies the type of buffer: QUEUE
- */
-void insert_remove_mns(vector<int>& input_data, 
-                       vector<int>& output_data, 
-                       int thread_id, 
-                       int buffer_type) {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {  
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            mns_queue_buffer.insert(input_data[push_index]);
-            //cout << "Thread ID>>: " << thread_id << "PUSH: "<< push_index<< endl;
-        }
-
-        // Try to pop an element from the queue
-        int element;
-        if (mns_queue_buffer.remove(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-            //cout << "Thread ID<<: " << thread_id << "POP: "<< pop_index<< endl;
-        }else{
-            pop_index = output_index;
-        }
-        //cout << "Thread ID: " << thread_id << endl;
-        // Check for boundary condition: input exhausted and queue empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        //cout << "Thread ID: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-/**
- * Function to insert elements into the Treiber stack (elimination) in a thread-safe manner.
- * 
- * @param fptr_src - Input file stream containing elements to insert
- * @param thread_id - ID of the thread performing the operation (for debugging/logging)
- * @param buffer_type - Specifies the type of buffer: STACK
- */
-void insert_remove_treiber_elim(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type) {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif   
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            treiber_stack_elim_buffer.push(input_data[push_index]);
-            //cout << "Thread ID>>: " << thread_id << "PUSH: "<< push_index<< endl;
-        }
-        // Try to pop an element from the stack
-        int element;
-        if (treiber_stack_elim_buffer.pop(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-            //cout << "Thread ID<<: " << thread_id << "POP: "<< element<< endl;
-        }else{
-            pop_index = output_index;
-        }
-            
-        
-        // Check for the boundary condition: file end and stack empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-            cout << "Thread exit: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-/**
- * Function to insert elements into a stack with elimination in a thread-safe manner.
- * 
- * @param fptr_src - Input file stream containing elements to insert
- * @param thread_id - ID of the thread performing the operation (for debugging/logging)
- * @param buffer_type - Specifies the type of buffer: STACK
- */
-void insert_remove_sgl_elim(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type) {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif   
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            stack_elim_buffer.push(input_data[push_index]);
-        }
-        // Try to pop an element from the stack
-        int element;
-        if (stack_elim_buffer.pop(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-        }else{
-            pop_index = output_index;
-        }
-        // Check for the boundary condition: file end and stack empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-            //cout << "Thread exit: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
-
-/**
- * Function to insert elements into a flat stack in a thread-safe manner.
- * 
- */
-void insert_remove_stack_flat(vector<int>& input_data, 
-                             vector<int>& output_data, 
-                             int thread_id, 
-                             int buffer_type) {
-    int push_index = 0;
-    int pop_index = 0;
-
-    while (true) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-        cout << "Thread ID: " << thread_id << endl;
-#endif   
-        // Fetch the next index for insertion and check bounds
-        push_index = fai(input_index, 1, ACQ_REL);
-        if (push_index < (int)input_data.size()) {
-            stack_flat_buffer.push(input_data[push_index]);
-        }
-        // Try to pop an element from the stack
-        int element;
-        if (stack_flat_buffer.pop(element)) {
-            // Fetch the next index for output and store the popped element
-            pop_index = fai(output_index, 1, ACQ_REL);
-            output_data[pop_index] = element;
-        }else{
-            pop_index = output_index;
-        }
-        // Check for the boundary condition: file end and stack empty
-        if (push_index >= (int)input_data.size() && pop_index >= (int)output_data.size() - 10) {
-#ifdef DEBUG
-        // Debugging/logging: Print the thread ID
-            cout << "Thread exit: " << thread_id << endl;
-#endif 
-            break;
-        }
-    }
-}
+#include "parallelized_code.hpp"
+#include "buffer.hpp"
+#include "command_handling.hpp"
+#include "latency.hpp"
+#include "affinity.hpp"
+#include <mutex>
+#include <iostream>
+#include <thread>
+#include <pthread.h>
+#include <barrier>
+#include <chrono>
+
+
+template <typename T>
+T fai(atomic<T> &status, type_identity_t<T> amount, memory_order mem_order) {  // amount converts to T
+    // Atomically add 'amount' to 'status' and return the previous value
+    return status.fetch_add(amount, mem_order);
+}
+
+// Lock-based buffers built with one lock policy
+template <typename Lock>
+struct locked_buffers {
+    stack<int, Lock> sgl_stack;
+    queue<int, Lock> sgl_queue;
+    stack_elim<int, Lock> elim_stack{ELIM_MAX_WIDTH};
+    stack_flat<int, Lock> flat_stack;
+    queue_flat<int, Lock> flat_queue;
+    twolock_queue<int, Lock> twolock;
+};
+
+// Global lock-based buffers, one set per lock policy (selected with --lock)
+locked_buffers<tas_lock> tas_buffers;
+locked_buffers<ttas_lock> ttas_buffers;
+locked_buffers<ticket_lock> ticket_buffers;
+locked_buffers<mcs_lock> mcs_buffers;
+locked_buffers<clh_lock> clh_buffers;
+
+// Lock-free buffers, one per reclamation policy (selected with --reclaim)
+treiber_stack<int, leak_reclaimer> trieber_stack_leak_buffer;
+treiber_stack<int, hazard_pointer_reclaimer> trieber_stack_hp_buffer;
+treiber_stack<int, epoch_reclaimer> trieber_stack_ebr_buffer;
+
+treiber_stack_tagged<int> treiber_stack_tagged_buffer;
+
+mns_queue<int, leak_reclaimer> mns_queue_leak_buffer;
+mns_queue<int, hazard_pointer_reclaimer> mns_queue_hp_buffer;
+mns_queue<int, epoch_reclaimer> mns_queue_ebr_buffer;
+
+faa_queue<int, leak_reclaimer> faa_queue_leak_buffer;
+faa_queue<int, hazard_pointer_reclaimer> faa_queue_hp_buffer;
+faa_queue<int, epoch_reclaimer> faa_queue_ebr_buffer;
+
+mns_elim_queue<int, leak_reclaimer> mns_elim_queue_leak_buffer(ELIM_MAX_WIDTH);
+mns_elim_queue<int, hazard_pointer_reclaimer> mns_elim_queue_hp_buffer(ELIM_MAX_WIDTH);
+mns_elim_queue<int, epoch_reclaimer> mns_elim_queue_ebr_buffer(ELIM_MAX_WIDTH);
+
+treiber_stack_elim<int, leak_reclaimer> treiber_stack_elim_leak_buffer(ELIM_MAX_WIDTH);
+treiber_stack_elim<int, hazard_pointer_reclaimer> treiber_stack_elim_hp_buffer(ELIM_MAX_WIDTH);
+treiber_stack_elim<int, epoch_reclaimer> treiber_stack_elim_ebr_buffer(ELIM_MAX_WIDTH);
+
+dual_stack<int, leak_reclaimer> dual_stack_leak_buffer;
+dual_stack<int, hazard_pointer_reclaimer> dual_stack_hp_buffer;
+dual_stack<int, epoch_reclaimer> dual_stack_ebr_buffer;
+
+dual_queue<int, leak_reclaimer> dual_queue_leak_buffer;
+dual_queue<int, hazard_pointer_reclaimer> dual_queue_hp_buffer;
+dual_queue<int, epoch_reclaimer> dual_queue_ebr_buffer;
+
+skiplist_pq<int, leak_reclaimer> skiplist_pq_leak_buffer;
+skiplist_pq<int, epoch_reclaimer> skiplist_pq_ebr_buffer;
+
+// 64-bit: the input is replayed BENCH_ROUNDS times, so the indices run up to size * BENCH_ROUNDS
+atomic<long long> input_index = 0;
+atomic<long long> output_index = 0;
+
+// Atomic flag to indicate whether the file reading is complete
+atomic<bool> read_complete = false;
+
+/**
+ * Batched variant of insert_remove_buffer, used when --batch is greater than 1.
+ * Each iteration claims up to BATCH_SIZE input elements, pushes them with one push_bulk and pops up to
+ * BATCH_SIZE elements with one pop_bulk. A bounded buffer may accept only part of a batch; the rest is
+ * kept and retried after the pop, as with try_push. Once the thread has pushed all its input, a stack with
+ * drain (Treiber) is emptied with one drain call per iteration instead of pop_bulk.
+ *
+ * @param buffer - Stack or queue to exercise
+ * @param input_data - Elements to push; replayed BENCH_ROUNDS times
+ * @param output_data - Popped elements (the last round overwrites the earlier ones)
+ */
+template <typename Buffer>
+void insert_remove_batch(Buffer &buffer,
+                         vector<int>& input_data,
+                         vector<int>& output_data) {
+    int size = input_data.size();
+    long long total = (long long)size * BENCH_ROUNDS;
+    int batch = BATCH_SIZE;
+    vector<int> pending;       // Claimed input elements
+    size_t pushed = 0;         // Elements of pending already accepted by the buffer
+    vector<int> popped(batch); // Elements returned by pop_bulk (or drain)
+    bool exhausted = false;    // No input left to claim
+    long long pop_index = 0;
+
+    while (true) {
+        if (pushed == pending.size() && !exhausted) {
+            // Claim the next batch of input indices, without overflowing the shared index once input is exhausted
+            long long start = input_index.load(RELAXED) < total ? fai(input_index, batch, ACQ_REL) : total;
+            long long end = min(start + batch, total);
+            pending.clear();
+            pushed = 0;
+            for (long long i = start; i < end; i++) {
+                pending.push_back(input_data[i % size]);
+            }
+            exhausted = end >= total;
+        }
+        if (pushed < pending.size()) {
+            if constexpr (requires { buffer.try_push(input_data[0]); }) {
+                pushed += buffer.push_bulk(pending.begin() + pushed, pending.end());  // Backpressure: keep the rest
+            } else {
+                buffer.push_bulk(pending.begin() + pushed, pending.end());
+                pushed = pending.size();
+            }
+        }
+
+        int count;
+        if constexpr (requires { buffer.drain(popped); }) {
+            if (exhausted && pushed == pending.size()) {
+                popped.clear();
+                count = buffer.drain(popped);  // Nothing left to push: take whatever is on the stack at once
+                popped.resize(max(count, batch));
+            } else {
+                count = buffer.pop_bulk(popped.data(), batch);
+            }
+        } else {
+            count = buffer.pop_bulk(popped.data(), batch);
+        }
+        if (count > 0) {
+            // Reserve count output slots at once and store the popped elements
+            pop_index = fai(output_index, count, ACQ_REL);
+            for (int i = 0; i < count; i++) {
+                output_data[(pop_index + i) % size] = popped[i];
+            }
+            pop_index += count;
+        } else {
+            pop_index = output_index;
+        }
+        // Check for boundary condition: input exhausted, batch pushed and buffer empty
+        if (exhausted && pushed == pending.size() && pop_index >= total) {
+            break;
+        }
+    }
+}
+
+#define WORKLOAD_CLOCK_INTERVAL (1024)  // Operations between two reads of the clock in a --duration run
+
+workload_stats workload_results[MAX_THREADS];  // Counters of each thread of the last workload run
+
+/**
+ * Synthetic workload (--ops or --duration) on one buffer. The thread first pushes its share of --prefill,
+ * waits for every other thread, then runs its role until it has done its share of --ops or --duration has
+ * passed: producers only push, consumers only pop and every other thread pushes with probability --mix.
+ * Keys are read round robin from the pool generated by main, starting at a different offset per thread,
+ * so the hot loop does not pay for the key distribution. Every push and pop attempt counts as an operation,
+ * including pops that found the buffer empty and pushes a full bounded buffer refused.
+ *
+ * @param buffer - Stack, queue or priority queue to exercise
+ * @param keys - Key pool generated by main
+ * @param thread_id - Decides the role and the share of the prefill and of --ops
+ */
+template <typename Buffer>
+void workload_buffer(Buffer &buffer, vector<int>& keys, int thread_id) {
+    static barrier start(NUM_THREADS);  // Prefill done everywhere before any clock starts
+    size_t pool = keys.size();
+    size_t key = pool * thread_id / NUM_THREADS;
+    auto push = [&]() {  // Push the next key of the pool, false if a bounded buffer is full
+        int element = keys[key];
+        key = key + 1 < pool ? key + 1 : 0;
+        if constexpr (requires { buffer.try_push(element); }) {
+            return buffer.try_push(element);
+        } else if constexpr (requires { buffer.push(element); }) {
+            buffer.push(element);
+        } else {
+            buffer.insert(element);
+        }
+        return true;
+    };
+    auto pop = [&]() {  // Pop one element, false if the buffer was empty
+        int element;
+        if constexpr (requires { buffer.pop_wait_for(element, chrono::microseconds(1)); }) {
+            if (WAIT_TIMEOUT_US) {
+                return buffer.pop_wait_for(element, chrono::microseconds(WAIT_TIMEOUT_US));  // Park while empty
+            }
+        }
+        if constexpr (requires { buffer.pop(element); }) {
+            return buffer.pop(element);
+        } else if constexpr (requires { buffer.delete_min(element); }) {
+            return buffer.delete_min(element);
+        } else {
+            return buffer.remove(element);
+        }
+    };
+
+    for (unsigned long long i = PREFILL * thread_id / NUM_THREADS; i < PREFILL * (thread_id + 1) / NUM_THREADS; i++) {
+        push();
+    }
+    start.arrive_and_wait();
+
+    unsigned percent = (unsigned)thread_id < PRODUCERS ? 100 : (unsigned)thread_id < PRODUCERS + CONSUMERS ? 0 : PUSH_PERCENT;
+    unsigned long long limit = WORKLOAD_OPS ? WORKLOAD_OPS * (thread_id + 1) / NUM_THREADS - WORKLOAD_OPS * thread_id / NUM_THREADS : ~0ull;
+    workload_stats stats = {0, 0, 0, 0, 0.0};
+    latency_histogram *latency = LATENCY ? latency_thread_histogram() : nullptr;  // --latency: time each call
+    uint32_t seed = 2654435761u * (thread_id + 1);  // xorshift state for the push/pop choice
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    chrono::steady_clock::time_point deadline = begin + chrono::milliseconds(WORKLOAD_DURATION_MS);
+
+    while (stats.ops < limit) {
+        if (!WORKLOAD_OPS && stats.ops % WORKLOAD_CLOCK_INTERVAL == 0 && chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        unsigned long long start = latency ? latency_now() : 0;
+        if (seed % 100 < percent) {
+            stats.pushes += push();
+            if (latency) {
+                latency->record(LATENCY_PUSH, latency_now() - start);
+            }
+        } else {
+            bool popped = pop();
+            if (latency) {
+                latency->record(popped ? LATENCY_POP : LATENCY_EMPTY, latency_now() - start);
+            }
+            stats.pops += popped;
+            stats.empty += !popped;
+        }
+        stats.ops++;
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    workload_results[thread_id] = stats;
+}
+
+/**
+ * Counters of one thread of the last workload run.
+ */
+workload_stats workload_thread_stats(int thread_id) {
+    return workload_results[thread_id];
+}
+
+/**
+ * Generic push/pop loop shared by the drivers whose buffer is picked at run time.
+ * Each iteration pushes the next input element and pops one element, until every element
+ * of every benchmark round has been popped. Stacks expose push/pop, queues insert/remove.
+ * Bounded buffers expose try_push: when it reports full the element is kept and retried
+ * after the pop, so a producer is throttled instead of spinning on a full buffer.
+ * With --wait the pop is pop_wait_for, so a thread that finds the buffer empty sleeps until a push
+ * or the timeout instead of going round the loop again.
+ *
+ * With --ops or --duration the buffer runs the synthetic workload instead (workload_buffer).
+ *
+ * @param buffer - Stack or queue to exercise
+ * @param input_data - Elements to push; replayed BENCH_ROUNDS times
+ * @param output_data - Popped elements (the last round overwrites the earlier ones)
+ * @param thread_id - Index of the calling thread (role and share of the workload)
+ */
+template <typename Buffer>
+void insert_remove_buffer(Buffer &buffer,
+                          vector<int>& input_data,
+                          vector<int>& output_data,
+                          int thread_id) {
+    if (WORKLOAD) {
+        workload_buffer(buffer, input_data, thread_id);
+        return;
+    }
+    if (BATCH_SIZE > 1) {
+        insert_remove_batch(buffer, input_data, output_data);
+        return;
+    }
+    int size = input_data.size();
+    long long total = (long long)size * BENCH_ROUNDS;
+    long long push_index = 0;
+    long long pop_index = 0;
+    bool pending = false;  // push_index was rejected by a full bounded buffer and must be retried
+    latency_histogram *latency = LATENCY ? latency_thread_histogram() : nullptr;  // --latency: time each call
+
+    while (true) {
+        // Fetch the next index for insertion, without overflowing the shared index once input is exhausted
+        if (!pending) {
+            push_index = input_index.load(RELAXED) < total ? fai(input_index, 1, ACQ_REL) : total;
+        }
+        if (push_index < total) {
+            unsigned long long start = latency ? latency_now() : 0;
+            if constexpr (requires { buffer.try_push(input_data[0]); }) {
+                pending = !buffer.try_push(input_data[push_index % size]);  // Backpressure: pop before retrying
+            } else if constexpr (requires { buffer.push(input_data[0]); }) {
+                buffer.push(input_data[push_index % size]);
+            } else {
+                buffer.insert(input_data[push_index % size]);
+            }
+            if (latency) {
+                latency->record(LATENCY_PUSH, latency_now() - start);
+            }
+        }
+
+        // Try to pop an element from the buffer
+        int element;
+        bool popped;
+        unsigned long long start = latency ? latency_now() : 0;
+        if (WAIT_TIMEOUT_US) {
+            popped = buffer.pop_wait_for(element, chrono::microseconds(WAIT_TIMEOUT_US));  // Park while empty
+        } else if constexpr (requires { buffer.pop(element); }) {
+            popped = buffer.pop(element);
+        } else {
+            popped = buffer.remove(element);
+        }
+        if (latency) {
+            latency->record(popped ? LATENCY_POP : LATENCY_EMPTY, latency_now() - start);
+        }
+        if (popped) {
+            // Fetch the next index for output and store the popped element
+            pop_index = fai(output_index, 1, ACQ_REL);
+            output_data[pop_index % size] = element;
+        } else {
+            pop_index = output_index;
+        }
+        // Check for boundary condition: input exhausted and buffer empty
+        if (push_index >= total && pop_index >= total) {
+            break;
+        }
+    }
+}
+
+/**
+ * Run a driver on the set of lock-based buffers built with the lock selected by --lock.
+ *
+ * @param run - Called with the locked_buffers of the selected policy
+ */
+template <typename Run>
+void with_lock_policy(Run run) {
+    if (LOCK_POLICY == LOCK_TAS) {
+        run(tas_buffers);
+    } else if (LOCK_POLICY == LOCK_TTAS) {
+        run(ttas_buffers);
+    } else if (LOCK_POLICY == LOCK_TICKET) {
+        run(ticket_buffers);
+    } else if (LOCK_POLICY == LOCK_CLH) {
+        run(clh_buffers);
+    } else {
+        run(mcs_buffers);
+    }
+}
+
+void insert_remove_sgl_stack(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type)  {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.sgl_stack, input_data, output_data, thread_id);
+    });
+}
+
+
+void insert_remove_sgl_queue(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type) {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.sgl_queue, input_data, output_data, thread_id);
+    });
+}
+
+void insert_remove_treiber(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type)  {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(trieber_stack_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(trieber_stack_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(trieber_stack_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to insert elements into the ABA-safe tagged Treiber stack in a thread-safe manner.
+ */
+void insert_remove_treiber_tagged(vector<int>& input_data, 
+                                  vector<int>& output_data, 
+                                  int thread_id, 
+                                  int buffer_type) {
+    insert_remove_buffer(treiber_stack_tagged_buffer, input_data, output_data, thread_id);
+}
+
+/**
+ * Function to insert elements into a lock-free MNS queue in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_mns(vector<int>& input_data, 
+                       vector<int>& output_data, 
+                       int thread_id, 
+                       int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(mns_queue_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(mns_queue_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(mns_queue_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to insert elements into the flat-combining queue in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_queue_flat(vector<int>& input_data, 
+                              vector<int>& output_data, 
+                              int thread_id, 
+                              int buffer_type) {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.flat_queue, input_data, output_data, thread_id);
+    });
+}
+
+/**
+ * Function to insert elements into the two-lock queue in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_twolock(vector<int>& input_data, 
+                           vector<int>& output_data, 
+                           int thread_id, 
+                           int buffer_type) {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.twolock, input_data, output_data, thread_id);
+    });
+}
+
+/**
+ * Function to insert elements into the fetch-and-add segment queue in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_faa(vector<int>& input_data, 
+                       vector<int>& output_data, 
+                       int thread_id, 
+                       int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(faa_queue_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(faa_queue_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(faa_queue_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to insert elements into the M&S queue with elimination in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_mns_elim(vector<int>& input_data, 
+                            vector<int>& output_data, 
+                            int thread_id, 
+                            int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(mns_elim_queue_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(mns_elim_queue_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(mns_elim_queue_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to insert elements into the bounded ring queue in a thread-safe manner.
+ * The ring is created on first use so it picks up the --capacity given on the command line.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_ring(vector<int>& input_data, 
+                        vector<int>& output_data, 
+                        int thread_id, 
+                        int buffer_type) {
+    static ring_queue<int> ring_queue_buffer(RING_CAPACITY);
+    insert_remove_buffer(ring_queue_buffer, input_data, output_data, thread_id);
+}
+
+// Pin the calling thread to one CPU (wrapping around when there are fewer CPUs than threads)
+static void pin_to_cpu(int cpu) {
+    unsigned cpus = thread::hardware_concurrency();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus ? cpu % cpus : 0, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * Function to pass elements through the SPSC ring queue.
+ * Thread 0 is the only producer and thread 1 the only consumer, each pinned to its own CPU;
+ * main starts exactly two threads for this mode. The ring is created on first use so it picks up --capacity.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - 0 for the producer, 1 for the consumer
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_spsc(vector<int>& input_data, 
+                        vector<int>& output_data, 
+                        int thread_id, 
+                        int buffer_type) {
+    static spsc_queue<int> spsc_queue_buffer(RING_CAPACITY);
+    int size = input_data.size();
+    long long total = (long long)size * BENCH_ROUNDS;
+
+    if (AFFINITY_POLICY == AFFINITY_NONE) {
+        pin_to_cpu(thread_id);  // Otherwise start_worker has already placed the thread
+    }
+    if (BATCH_SIZE > 1) {
+        // Batched: the producer publishes and the consumer releases up to BATCH_SIZE cells per index update
+        vector<int> batch(BATCH_SIZE);
+        if (thread_id == 0) {
+            for (long long push_index = 0; push_index < total; ) {
+                int count = min<long long>(BATCH_SIZE, total - push_index);
+                for (int i = 0; i < count; i++) {
+                    batch[i] = input_data[(push_index + i) % size];
+                }
+                for (int done = 0; done < count; ) {
+                    int pushed = spsc_queue_buffer.push_bulk(batch.begin() + done, batch.begin() + count);
+                    if (!pushed) {
+                        this_thread::yield();  // Full: let the consumer catch up
+                    }
+                    done += pushed;
+                }
+                push_index += count;
+            }
+        } else if (thread_id == 1) {
+            for (long long pop_index = 0; pop_index < total; ) {
+                int count = spsc_queue_buffer.pop_bulk(batch.data(), BATCH_SIZE);
+                if (!count) {
+                    this_thread::yield();  // Empty: let the producer catch up
+                }
+                for (int i = 0; i < count; i++) {
+                    output_data[(pop_index + i) % size] = batch[i];
+                }
+                pop_index += count;
+            }
+        }
+    } else if (thread_id == 0) {
+        for (long long push_index = 0; push_index < total; push_index++) {
+            while (!spsc_queue_buffer.try_push(input_data[push_index % size])) {
+                this_thread::yield();  // Full: let the consumer catch up
+            }
+        }
+    } else if (thread_id == 1) {
+        int element;
+        for (long long pop_index = 0; pop_index < total; pop_index++) {
+            if (WAIT_TIMEOUT_US) {
+                spsc_queue_buffer.pop_wait(element);  // Empty: sleep until the producer pushes
+            } else {
+                while (!spsc_queue_buffer.try_pop(element)) {
+                    this_thread::yield();  // Empty: let the producer catch up
+                }
+            }
+            output_data[pop_index % size] = element;
+        }
+    }
+}
+
+/**
+ * Function to insert elements into the Treiber stack (elimination) in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: STACK
+ */
+void insert_remove_treiber_elim(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(treiber_stack_elim_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(treiber_stack_elim_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(treiber_stack_elim_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to insert elements into a stack with elimination in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: STACK
+ */
+void insert_remove_sgl_elim(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type) {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.elim_stack, input_data, output_data, thread_id);
+    });
+}
+
+/**
+ * Function to insert elements into a flat stack in a thread-safe manner.
+ * 
+ */
+void insert_remove_stack_flat(vector<int>& input_data, 
+                             vector<int>& output_data, 
+                             int thread_id, 
+                             int buffer_type) {
+    with_lock_policy([&](auto &buffers) {
+        insert_remove_buffer(buffers.flat_stack, input_data, output_data, thread_id);
+    });
+}
+
+/**
+ * Function to pass elements through the dual stack in a thread-safe manner.
+ * A pop on an empty stack waits on its own reservation for up to DUAL_POP_WAIT ns before the driver retries.
+ *
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: STACK
+ */
+void insert_remove_dual_stack(vector<int>& input_data, 
+                              vector<int>& output_data, 
+                              int thread_id, 
+                              int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(dual_stack_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(dual_stack_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(dual_stack_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Function to pass elements through the dual queue in a thread-safe manner.
+ * A remove on an empty queue waits on its own reservation for up to DUAL_POP_WAIT ns before the driver retries.
+ *
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_dual_queue(vector<int>& input_data, 
+                              vector<int>& output_data, 
+                              int thread_id, 
+                              int buffer_type) {
+    if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_buffer(dual_queue_leak_buffer, input_data, output_data, thread_id);
+    } else if (RECLAIM_POLICY == RECLAIM_HP) {
+        insert_remove_buffer(dual_queue_hp_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_buffer(dual_queue_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+// Relaxed buffers, created on first use so they pick up --shards, -t and --rank
+static multi_stack<int> &multi_stack_buffer() {
+    static multi_stack<int> buffer(MULTI_SHARDS ? MULTI_SHARDS : 2 * NUM_THREADS, RANK_ERROR);
+    return buffer;
+}
+
+static multi_queue<int> &multi_queue_buffer() {
+    static multi_queue<int> buffer(MULTI_SHARDS ? MULTI_SHARDS : 2 * NUM_THREADS, RANK_ERROR);
+    return buffer;
+}
+
+/**
+ * Function to pass elements through the relaxed sharded stack in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: STACK
+ */
+void insert_remove_multi_stack(vector<int>& input_data, 
+                               vector<int>& output_data, 
+                               int thread_id, 
+                               int buffer_type) {
+    insert_remove_buffer(multi_stack_buffer(), input_data, output_data, thread_id);
+}
+
+/**
+ * Function to pass elements through the relaxed sharded queue in a thread-safe manner.
+ * 
+ * @param fptr_src - Input file stream containing elements to insert
+ * @param thread_id - ID of the thread performing the operation (for debugging/logging)
+ * @param buffer_type - Specifies the type of buffer: QUEUE
+ */
+void insert_remove_multi_queue(vector<int>& input_data, 
+                               vector<int>& output_data, 
+                               int thread_id, 
+                               int buffer_type) {
+    insert_remove_buffer(multi_queue_buffer(), input_data, output_data, thread_id);
+}
+
+/**
+ * Rank error of the multi stack or queue after a run with --rank.
+ *
+ * @param buffer_type - STACK or QUEUE
+ * @return Pops measured, mean and largest rank error
+ */
+rank_error_stats multi_rank_error(int buffer_type) {
+    return buffer_type == STACK ? multi_stack_buffer().rank_error() : multi_queue_buffer().rank_error();
+}
+
+/**
+ * Work-stealing driver: every thread owns a Chase-Lev deque, seeds it with its own contiguous share of
+ * input_data (once per benchmark round) and pops from it LIFO. A thread whose deque is empty first seeds
+ * its next round, then steals FIFO from randomly chosen victims until every element has been popped.
+ * Only the steals touch another thread's cache lines, unlike the shared stacks where every push and pop
+ * goes through one top.
+ *
+ * @param input_data - Elements to distribute; thread i owns [size * i / threads, size * (i + 1) / threads)
+ * @param output_data - Popped elements (the last round overwrites the earlier ones)
+ * @param thread_id - Index of the thread's own deque
+ * @param buffer_type - Specifies the type of buffer: STACK
+ */
+void insert_remove_work_stealing(vector<int>& input_data,
+                                 vector<int>& output_data,
+                                 int thread_id,
+                                 int buffer_type) {
+    static vector<ws_deque<int>> deques(NUM_THREADS);  // One deque per thread
+    ws_deque<int> &mine = deques[thread_id];
+    int size = input_data.size();
+    long long total = (long long)size * BENCH_ROUNDS;
+    int begin = (long long)size * thread_id / NUM_THREADS;
+    int end = (long long)size * (thread_id + 1) / NUM_THREADS;
+    unsigned rounds = 0;                          // Rounds of the own share seeded so far
+    uint32_t seed = 2654435761u * (thread_id + 1); // xorshift state for the victim choice
+    int failed = 0;                               // Steals in a row that came back empty
+
+    while (true) {
+        int element;
+        bool popped = mine.pop(element);
+        if (!popped && rounds < BENCH_ROUNDS) {
+            // Own work ran out: seed the next round of this thread's share
+            for (int i = begin; i < end; i++) {
+                mine.push(input_data[i]);
+            }
+            rounds++;
+            continue;
+        }
+        if (!popped && NUM_THREADS > 1) {
+            // Steal the oldest element of a random other thread's deque
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            int victim = (thread_id + 1 + seed % (NUM_THREADS - 1)) % NUM_THREADS;
+            popped = deques[victim].steal(element);
+        }
+        if (popped) {
+            output_data[fai(output_index, 1, ACQ_REL) % size] = element;
+            failed = 0;
+        } else if (output_index.load(ACQ) >= total) {
+            break;  // Every element of every round has been popped
+        } else if (++failed % WS_YIELD_INTERVAL == 0) {
+            this_thread::yield();  // The owners still working may be descheduled
+        } else {
+            cpu_relax();
+        }
+    }
+}
+
+// Threads of the last priority queue run whose own delete_min results came out in non-decreasing order
+atomic<unsigned> pq_sorted_threads = 0;
+
+/**
+ * Phased run of a priority queue: every round, each thread inserts its contiguous share of input_data, waits
+ * for the others, then calls delete_min until the queue is empty. With no insert running during the deletes,
+ * each thread must see its own keys come out in non-decreasing order; a thread that does in every round
+ * counts towards pq_sorted_threads.
+ * With --overlap a thread also calls delete_min after every second insert, so deletes (and the prefix cuts
+ * they trigger) run against concurrent inserts. Those deletes are not part of the order check, which only
+ * covers the drain after the barrier; main checks that every key came out exactly once.
+ *
+ * @param buffer - Priority queue to exercise
+ * @param input_data - Keys to insert; thread i owns [size * i / threads, size * (i + 1) / threads)
+ * @param output_data - Deleted keys (the last round overwrites the earlier ones)
+ * @param thread_id - Index of the thread's share
+ */
+template <typename PQ>
+void insert_remove_priority(PQ &buffer,
+                            vector<int>& input_data,
+                            vector<int>& output_data,
+                            int thread_id) {
+    static barrier phase(NUM_THREADS);  // Separates the insert and delete_min phases of every round
+    int size = input_data.size();
+    int begin = (long long)size * thread_id / NUM_THREADS;
+    int end = (long long)size * (thread_id + 1) / NUM_THREADS;
+    bool sorted = true;
+    latency_histogram *latency = LATENCY ? latency_thread_histogram() : nullptr;  // --latency: time each call
+
+    for (unsigned round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = begin; i < end; i++) {
+            unsigned long long start = latency ? latency_now() : 0;
+            buffer.insert(input_data[i]);
+            if (latency) {
+                latency->record(LATENCY_PUSH, latency_now() - start);
+            }
+            if (PQ_OVERLAP && (i - begin) % 2 == 1) {
+                int element;
+                start = latency ? latency_now() : 0;
+                bool deleted = buffer.delete_min(element);
+                if (latency) {
+                    latency->record(deleted ? LATENCY_POP : LATENCY_EMPTY, latency_now() - start);
+                }
+                if (deleted) {
+                    output_data[fai(output_index, 1, ACQ_REL) % size] = element;
+                }
+            }
+        }
+        phase.arrive_and_wait();  // Every key is in before the drain
+
+        int element;
+        bool first = true;
+        int last = 0;
+        while (true) {
+            unsigned long long start = latency ? latency_now() : 0;
+            bool deleted = buffer.delete_min(element);
+            if (latency) {
+                latency->record(deleted ? LATENCY_POP : LATENCY_EMPTY, latency_now() - start);
+            }
+            if (!deleted) {
+                break;
+            }
+            output_data[fai(output_index, 1, ACQ_REL) % size] = element;
+            sorted = sorted && (first || last <= element);
+            first = false;
+            last = element;
+        }
+        phase.arrive_and_wait();  // Nobody inserts the next round while others still delete
+    }
+    if (sorted) {
+        pq_sorted_threads.fetch_add(1, RELAXED);
+    }
+}
+
+/**
+ * Function to pass elements through the lock-free skiplist priority queue.
+ * --reclaim=hp runs with EBR, since hazard pointers cannot protect a skiplist walk.
+ *
+ * @param thread_id - Index of the thread's share of the input
+ * @param buffer_type - Specifies the type of buffer: PRIORITY
+ */
+void insert_remove_skiplist_pq(vector<int>& input_data,
+                               vector<int>& output_data,
+                               int thread_id,
+                               int buffer_type) {
+    if (WORKLOAD) {
+        if (RECLAIM_POLICY == RECLAIM_LEAK) {
+            workload_buffer(skiplist_pq_leak_buffer, input_data, thread_id);
+        } else {
+            workload_buffer(skiplist_pq_ebr_buffer, input_data, thread_id);
+        }
+    } else if (RECLAIM_POLICY == RECLAIM_LEAK) {
+        insert_remove_priority(skiplist_pq_leak_buffer, input_data, output_data, thread_id);
+    } else {
+        insert_remove_priority(skiplist_pq_ebr_buffer, input_data, output_data, thread_id);
+    }
+}
+
+/**
+ * Number of threads whose delete_min results were non-decreasing in every round of the last run.
+ */
+unsigned priority_sorted_threads() {
+    return pq_sorted_threads.load(RELAXED);
+}
+
+/**
+ * Entry point of every driver thread.
+ * With --affinity the thread is pinned first, then touches its node pool caches and latency histogram, so the
+ * memory it will use for the whole run is allocated from its own CPU's NUMA node (Linux places a page on the
+ * node of the thread that first writes it).
+ *
+ * @param driver - insert_remove_* function the thread runs
+ * @param cpu - CPU to pin the thread to, or -1 to leave it to the scheduler
+ */
+void start_worker(driver_fn driver,
+                  vector<int>& input_data,
+                  vector<int>& output_data,
+                  int thread_id,
+                  int buffer_type,
+                  int cpu) {
+    if (cpu >= 0) {
+        if (!affinity_pin(cpu)) {
+            cout << "Thread " << thread_id << " could not be pinned to CPU " << cpu << endl;
+        }
+        // The int nodes of the linked containers fall into these size classes
+        pool_warm(sizeof(node<int>));
+        pool_warm(sizeof(atomic_node<int>));
+        pool_warm(sizeof(seq_node<int>));
+        pool_warm(sizeof(dual_node<int>));
+        if (LATENCY) {
+            latency_thread_histogram();
+        }
+    }
+    driver(input_data, output_data, thread_id, buffer_type);
+}
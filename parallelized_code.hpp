@@ -1,19 +1,52 @@
-#include <fstream> // For input and output file stream operations
-#include <vector>
-
-
-using namespace std;
-
-
-void insert_remove_sgl_stack(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-void insert_remove_sgl_queue(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-void insert_remove_treiber(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-
-void insert_remove_mns(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-
-void insert_remove_treiber_elim(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-
-void insert_remove_sgl_elim(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
-
-
-void insert_remove_stack_flat(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+#include <fstream> // For input and output file stream operations
+#include <vector>
+
+
+using namespace std;
+
+
+void insert_remove_sgl_stack(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_sgl_queue(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_treiber(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_treiber_tagged(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_dual_stack(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_multi_stack(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_work_stealing(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+void insert_remove_mns(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_queue_flat(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_twolock(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_faa(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_mns_elim(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_ring(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_spsc(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_dual_queue(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void insert_remove_multi_queue(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+void insert_remove_treiber_elim(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+void insert_remove_sgl_elim(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+
+void insert_remove_stack_flat(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+void insert_remove_skiplist_pq(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+
+// Thread entry point: pins to cpu (unless it is -1) and warms the thread's state there before running the driver
+typedef void (*driver_fn)(vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type);
+void start_worker(driver_fn driver, vector<int> &input_data, vector<int> &output_data, int thread_id, int buffer_type, int cpu);
+unsigned priority_sorted_threads();  // Threads whose delete_min results came out non-decreasing (--pq)
+
+// Counters of one thread of a synthetic workload run (--ops / --duration)
+struct workload_stats {
+    unsigned long long ops;     // Push and pop attempts
+    unsigned long long pushes;  // Pushes the buffer accepted
+    unsigned long long pops;    // Pops that returned an element
+    unsigned long long empty;   // Pops that found the buffer empty
+    double seconds;             // Time the thread spent in the measured loop
+};
+
+workload_stats workload_thread_stats(int thread_id);  // Counters of one thread of the last workload run
+
+struct rank_error_stats;
+rank_error_stats multi_rank_error(int buffer_type);  // Rank error of the multi stack or queue (--rank)
@@ -0,0 +1,44 @@
+#include "buffer.hpp"
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static atomic<unsigned long long> total_parks(0);  // Futex waits entered by consumers
+static atomic<unsigned long long> total_wakes(0);  // Futex wakes issued by producers
+
+// The futex word is the gate's 32-bit state; atomic<unsigned> has the same layout as unsigned
+static unsigned *futex_word(atomic<unsigned> &word) {
+    return reinterpret_cast<unsigned *>(&word);
+}
+
+void park_gate::wake() {
+    unsigned current = state.load(RELAXED);
+    while (current & PARK_WAITING) {
+        // A consumer that read the old word will not go to sleep, and later pushes skip the syscall
+        if (state.compare_exchange_weak(current, (current + 2) & ~PARK_WAITING, SEQCST)) {
+            total_wakes.fetch_add(1, RELAXED);
+            syscall(SYS_futex, futex_word(state), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+            return;
+        }
+    }
+    // Another producer cleared the bit first and woke the sleepers
+}
+
+void park_gate::wait(unsigned key, long long timeout_ns) {
+    struct timespec timeout;
+    struct timespec *limit = nullptr;
+    if (timeout_ns >= 0) {
+        timeout.tv_sec = timeout_ns / 1000000000;
+        timeout.tv_nsec = timeout_ns % 1000000000;
+        limit = &timeout;
+    }
+    total_parks.fetch_add(1, RELAXED);
+    // Returns at once if the word moved past key; spurious wakeups and EINTR are fine, the caller re-checks
+    syscall(SYS_futex, futex_word(state), FUTEX_WAIT_PRIVATE, key, limit, nullptr, 0);
+}
+
+park_stats park_get_stats() {
+    return {total_parks.load(RELAXED), total_wakes.load(RELAXED)};
+}
@@ -0,0 +1,49 @@
+// Parking for the blocking pops (pop_wait / pop_wait_for) of the stacks and queues.
+// Included from buffer.hpp after the memory order macros, cpu_relax() and CACHE_ALIGNED, which it relies on.
+//
+// A park_gate is an event count: a consumer that found the container empty sets the waiting bit of the gate's
+// word, checks the container once more and sleeps on the word (futex) only if it is still empty. A producer
+// calls notify() after every push; only if the waiting bit is set does it clear it, bump the count and issue
+// the wake syscall, so a push nobody waits for costs one fence and one load, and a burst of pushes wakes once.
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+#define PARK_SPIN (256)         // Pops a waiting consumer retries (with a pause in between) before it parks
+#define PARK_FOREVER (-1ll)     // Timeout of pop_wait: never give up
+
+// Parking counters, kept in shared atomics (both events cost a syscall anyway)
+struct park_stats {
+    unsigned long long parks;  // Times a consumer went to sleep on a gate
+    unsigned long long wakes;  // Wake syscalls issued by producers
+};
+
+park_stats park_get_stats();  // Read the parking counters
+
+#define PARK_WAITING (1u)  // Low bit of a gate word: a consumer is (about to be) asleep on it
+
+class park_gate {
+    public:
+        CACHE_ALIGNED atomic<unsigned> state;  // (wake count << 1) | PARK_WAITING, the futex word
+
+        park_gate() : state(0) {}
+
+        // Producer: call after the element is visible in the container
+        void notify() {
+            atomic_thread_fence(SEQCST);  // Order the push before reading the waiting bit (pairs with prepare_wait)
+            if (state.load(RELAXED) & PARK_WAITING) {
+                wake();
+            }
+        }
+        void wake();  // Clear the waiting bit, bump the count and wake every thread sleeping on the word
+
+        // Consumer: announce the intent to sleep, then re-check the container before calling wait(key)
+        unsigned prepare_wait() {
+            unsigned key = state.fetch_or(PARK_WAITING, SEQCST) | PARK_WAITING;
+            atomic_thread_fence(SEQCST);  // Order the announcement before the re-check
+            return key;
+        }
+        void wait(unsigned key, long long timeout_ns);  // Sleep while the word is still key, at most timeout_ns (< 0: no limit)
+};
@@ -0,0 +1,247 @@
+#include "buffer.hpp"
+#include <algorithm>
+#include <iostream>
+
+// Spin lock protecting the orphan lists (only taken on thread exit and during scans)
+static void orphan_lock(atomic<bool> &lock) {
+    while (!cas(lock, false, true, ACQ_REL));
+}
+
+static void orphan_unlock(atomic<bool> &lock) {
+    lock.store(false, REL);
+}
+
+// Claim a free record from a fixed table and raise the scan bound to cover it
+template <typename Record>
+static Record *claim_record(Record *records, atomic<int> &high_water) {
+    for (int i = 0; i < MAX_THREADS; i++) {
+        if (!records[i].in_use.load(RELAXED) && cas(records[i].in_use, false, true, ACQ_REL)) {
+            int bound = high_water.load(ACQ);
+            while (bound < i + 1 && !high_water.compare_exchange_weak(bound, i + 1, ACQ_REL));
+            return &records[i];
+        }
+    }
+    // Not reached from the drivers: command_handle caps -t at MAX_THREADS before any thread starts
+    cout << "Reclamation domain is full, increase MAX_THREADS (" << MAX_THREADS << ")" << endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/******************************** Hazard pointers ********************************/
+
+static hp_record hp_records[MAX_THREADS];   // One record per registered thread
+static atomic<int> hp_high_water(0);        // Number of record slots ever claimed
+static atomic<bool> hp_orphans_lock(false);
+static vector<retired_node> hp_orphans;     // Nodes left behind by exited threads
+
+// Per-thread hazard pointer state
+struct hp_thread_state {
+    hp_record *rec = nullptr;        // Claimed record
+    vector<retired_node> retired;    // Nodes retired by this thread and not yet freed
+
+    ~hp_thread_state();
+};
+
+static thread_local hp_thread_state hp_local;
+
+// Free every retired node that is not published in any hazard slot
+static void hp_scan(vector<retired_node> &retired) {
+    vector<void *> hazards;
+    int bound = hp_high_water.load(ACQ);
+    for (int i = 0; i < bound; i++) {
+        for (int j = 0; j < HAZARDS_PER_THREAD; j++) {
+            void *ptr = hp_records[i].hazard[j].load(SEQCST);
+            if (ptr) {
+                hazards.push_back(ptr);
+            }
+        }
+    }
+    sort(hazards.begin(), hazards.end());
+
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++) {
+        if (binary_search(hazards.begin(), hazards.end(), retired[i].ptr)) {
+            retired[kept++] = retired[i];  // Still protected, keep it for the next scan
+        } else {
+            retired[i].deleter(retired[i].ptr);
+        }
+    }
+    retired.resize(kept);
+}
+
+hp_thread_state::~hp_thread_state() {
+    if (!rec) {
+        return;
+    }
+    hp_scan(retired);
+    if (!retired.empty()) {
+        // Still protected by someone else, leave them for the next scanning thread
+        orphan_lock(hp_orphans_lock);
+        hp_orphans.insert(hp_orphans.end(), retired.begin(), retired.end());
+        orphan_unlock(hp_orphans_lock);
+    }
+    for (int i = 0; i < HAZARDS_PER_THREAD; i++) {
+        rec->hazard[i].store(nullptr, REL);
+    }
+    rec->in_use.store(false, REL);
+}
+
+hazard_pointer_reclaimer::guard::guard() {
+    if (!hp_local.rec) {
+        hp_local.rec = claim_record(hp_records, hp_high_water);
+    }
+    rec = hp_local.rec;
+}
+
+hazard_pointer_reclaimer::guard::~guard() {
+    for (int i = 0; i < HAZARDS_PER_THREAD; i++) {
+        if (published & (1u << i)) {
+            rec->hazard[i].store(nullptr, REL);
+        }
+    }
+}
+
+void hazard_pointer_reclaimer::retire(void *ptr, reclaim_deleter deleter) {
+    vector<retired_node> &retired = hp_local.retired;
+    retired.push_back({ptr, deleter});
+    if (retired.size() < RETIRE_THRESHOLD) {
+        return;
+    }
+    // Adopt nodes orphaned by exited threads so they are not leaked
+    if (cas(hp_orphans_lock, false, true, ACQ_REL)) {
+        retired.insert(retired.end(), hp_orphans.begin(), hp_orphans.end());
+        hp_orphans.clear();
+        orphan_unlock(hp_orphans_lock);
+    }
+    hp_scan(retired);
+}
+
+
+/***************************** Epoch-based reclamation *****************************/
+
+static epoch_record epoch_records[MAX_THREADS];  // One record per registered thread
+static atomic<int> epoch_high_water(0);          // Number of record slots ever claimed
+static atomic<unsigned> global_epoch(1);         // Global epoch, only ever incremented
+
+// Node left behind by an exited thread, tagged with the epoch it was retired in
+struct epoch_orphan {
+    unsigned epoch;
+    retired_node node;
+};
+static atomic<bool> epoch_orphans_lock(false);
+static vector<epoch_orphan> epoch_orphans;
+
+// Per-thread epoch state: three limbo lists, one per epoch still in flight
+struct epoch_thread_state {
+    epoch_record *rec = nullptr;   // Claimed record
+    int depth = 0;                 // Guard nesting depth
+    unsigned retired_count = 0;    // Retires since the last advance attempt
+    vector<retired_node> limbo[3]; // Nodes retired in epoch limbo_epoch[i]
+    unsigned limbo_epoch[3] = {0, 0, 0};
+
+    ~epoch_thread_state();
+};
+
+static thread_local epoch_thread_state epoch_local;
+
+static void free_list(vector<retired_node> &list) {
+    for (size_t i = 0; i < list.size(); i++) {
+        list[i].deleter(list[i].ptr);
+    }
+    list.clear();
+}
+
+// Free the limbo lists that are at least two epochs behind the global epoch
+static void epoch_collect(epoch_thread_state &state, unsigned current) {
+    for (int i = 0; i < 3; i++) {
+        if (!state.limbo[i].empty() && state.limbo_epoch[i] + 2 <= current) {
+            free_list(state.limbo[i]);
+        }
+    }
+}
+
+// Advance the global epoch if every thread inside a guard has announced the current one
+static void epoch_try_advance() {
+    unsigned current = global_epoch.load(SEQCST);
+    int bound = epoch_high_water.load(ACQ);
+    for (int i = 0; i < bound; i++) {
+        unsigned announced = epoch_records[i].epoch.load(SEQCST);
+        if ((announced & EPOCH_ACTIVE) && (announced >> 1) != current) {
+            return;  // A thread is still running in an older epoch
+        }
+    }
+    cas(global_epoch, current, current + 1, ACQ_REL);
+
+    // Free orphans that are old enough
+    current = global_epoch.load(ACQ);
+    if (cas(epoch_orphans_lock, false, true, ACQ_REL)) {
+        size_t kept = 0;
+        for (size_t i = 0; i < epoch_orphans.size(); i++) {
+            if (epoch_orphans[i].epoch + 2 <= current) {
+                epoch_orphans[i].node.deleter(epoch_orphans[i].node.ptr);
+            } else {
+                epoch_orphans[kept++] = epoch_orphans[i];
+            }
+        }
+        epoch_orphans.resize(kept);
+        orphan_unlock(epoch_orphans_lock);
+    }
+}
+
+epoch_thread_state::~epoch_thread_state() {
+    if (!rec) {
+        return;
+    }
+    epoch_collect(*this, global_epoch.load(ACQ));
+    orphan_lock(epoch_orphans_lock);
+    for (int i = 0; i < 3; i++) {
+        for (size_t j = 0; j < limbo[i].size(); j++) {
+            epoch_orphans.push_back({limbo_epoch[i], limbo[i][j]});
+        }
+    }
+    orphan_unlock(epoch_orphans_lock);
+    rec->epoch.store(0, REL);
+    rec->in_use.store(false, REL);
+}
+
+epoch_reclaimer::guard::guard() {
+    epoch_thread_state &state = epoch_local;
+    if (state.depth++ > 0) {
+        return;  // Nested guard, the outer one already announced an epoch
+    }
+    if (!state.rec) {
+        state.rec = claim_record(epoch_records, epoch_high_water);
+    }
+    // Announce the global epoch, retrying if it moved before the announcement became visible
+    unsigned current;
+    do {
+        current = global_epoch.load(SEQCST);
+        state.rec->epoch.store((current << 1) | EPOCH_ACTIVE, SEQCST);
+    } while (current != global_epoch.load(SEQCST));
+    epoch_collect(state, current);
+}
+
+epoch_reclaimer::guard::~guard() {
+    epoch_thread_state &state = epoch_local;
+    if (--state.depth == 0) {
+        state.rec->epoch.store(0, REL);
+    }
+}
+
+void epoch_reclaimer::retire(void *ptr, reclaim_deleter deleter) {
+    epoch_thread_state &state = epoch_local;
+    // Tag with the global epoch read after the node was unlinked
+    unsigned current = global_epoch.load(SEQCST);
+    int index = current % 3;
+    if (state.limbo_epoch[index] != current) {
+        // The list holds nodes from epoch current - 3 or older, which are safe to free
+        free_list(state.limbo[index]);
+        state.limbo_epoch[index] = current;
+    }
+    state.limbo[index].push_back({ptr, deleter});
+    if (++state.retired_count >= RETIRE_THRESHOLD) {
+        state.retired_count = 0;
+        epoch_try_advance();
+        epoch_collect(state, global_epoch.load(ACQ));
+    }
+}
@@ -0,0 +1,121 @@
+// Safe memory reclamation policies for the lock-free containers.
+// Included from buffer.hpp after the memory order macros and cas(), which it relies on.
+//
+// Every policy exposes the same static interface so the containers can take it as a template parameter:
+//   - `typename Reclaimer::guard g;` must be held while dereferencing shared nodes
+//   - `g.protect(slot, src)` loads a shared pointer that stays safe to dereference while g is alive
+//   - `g.publish(slot, ptr)` announces a pointer read elsewhere; the caller must re-validate that it is still reachable
+//   - `Reclaimer::retire(ptr, deleter)` hands an unlinked node to the policy, which frees it once no thread can reach it
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+#define MAX_THREADS        (256)  // Maximum number of threads registered with a reclamation domain
+#define HAZARDS_PER_THREAD (2)    // Hazard slots per thread (the M&S dequeue protects head and head->next)
+#define RETIRE_THRESHOLD   (128)  // Retired nodes buffered per thread before a scan / epoch advance
+#define EPOCH_ACTIVE       (1u)   // Low bit of an epoch record: set while the thread is inside a guard
+
+// Function used by a policy to free a retired node
+typedef void (*reclaim_deleter)(void *);
+
+// A node that has been unlinked from its container but may still be referenced by other threads
+struct retired_node {
+    void *ptr;                // Address of the retired node
+    reclaim_deleter deleter;  // Function that frees it
+};
+
+// No reclamation: retired nodes are leaked (the original behaviour of mns_queue)
+struct leak_reclaimer {
+    class guard {
+        public:
+            template <typename N>
+            N *protect(int slot, atomic<N *> &src) {
+                return src.load(ACQ);
+            }
+            template <typename N>
+            void publish(int slot, N *ptr) {}
+    };
+
+    static void retire(void *ptr, reclaim_deleter deleter) {}
+};
+
+// Per-thread hazard pointer record, one cache line each so publishing a hazard does not invalidate other threads
+struct alignas(64) hp_record {
+    atomic<void *> hazard[HAZARDS_PER_THREAD];  // Nodes this thread is about to dereference
+    atomic<bool> in_use;                        // Record is owned by a live thread
+
+    hp_record() : in_use(false) {
+        for (int i = 0; i < HAZARDS_PER_THREAD; i++) {
+            hazard[i].store(nullptr, RELAXED);
+        }
+    }
+};
+
+// Hazard pointers (Michael 2004): a retired node is freed once no thread has published it in a hazard slot.
+// A guard only clears the slots it published itself, so a guard nested in another one (using other slots)
+// does not drop the outer guard's protection when it ends.
+class hazard_pointer_reclaimer {
+    public:
+        class guard {
+            hp_record *rec;          // Calling thread's record
+            unsigned published = 0;  // Bit i set once this guard has published into slot i
+
+            public:
+                guard();     // Look up (or claim) the calling thread's record
+                ~guard();    // Clear the hazard slots this guard published
+
+                // Publish the pointer in the slot and re-read src until the published value is still current
+                template <typename N>
+                N *protect(int slot, atomic<N *> &src) {
+                    N *ptr = src.load(ACQ);
+                    published |= 1u << slot;
+                    while (true) {
+                        rec->hazard[slot].store(ptr, SEQCST);
+                        N *again = src.load(SEQCST);
+                        if (again == ptr) {
+                            return ptr;
+                        }
+                        ptr = again;
+                    }
+                }
+
+                // Publish a pointer that was not read from an atomic (e.g. a plain next link)
+                template <typename N>
+                void publish(int slot, N *ptr) {
+                    published |= 1u << slot;
+                    rec->hazard[slot].store(ptr, SEQCST);
+                }
+        };
+
+        static void retire(void *ptr, reclaim_deleter deleter);
+};
+
+// Per-thread epoch record: (epoch << 1) | EPOCH_ACTIVE while inside a guard, 0 otherwise
+struct alignas(64) epoch_record {
+    atomic<unsigned> epoch;  // Announced epoch of the owning thread
+    atomic<bool> in_use;     // Record is owned by a live thread
+
+    epoch_record() : epoch(0), in_use(false) {}
+};
+
+// Epoch-based reclamation (Fraser 2004): a node retired in epoch e is freed once the global epoch reaches e + 2
+class epoch_reclaimer {
+    public:
+        class guard {
+            public:
+                guard();     // Announce the current global epoch
+                ~guard();    // Leave the critical section
+
+                template <typename N>
+                N *protect(int slot, atomic<N *> &src) {
+                    return src.load(ACQ);
+                }
+                template <typename N>
+                void publish(int slot, N *ptr) {}
+        };
+
+        static void retire(void *ptr, reclaim_deleter deleter);
+};
@@ -1,68 +1,269 @@
-#!/bin/bash
-
-make clean
-make
-
-./container -h
-
-# Arrays for parameter variations
-input_files=("1K_entry.txt")
-#"1_entry.txt" "100_entry.txt" "1K_entry.txt" "10K_entry.txt"
-
-num_threads=(4)
-#1 2 3 4 8 16
-
-stack_types=("sgl" "treiber" "sgl_elim" "treiber_elim" "stack_flat")
-#"sgl" "treiber" "sgl_elim" "treiber_elim" "stack_flat"
-
-queue_types=("sgl" "mns")
-#"sgl" "mns"
-
-# Iterate over input files
-for input_file in "${input_files[@]}"; do
-  # Iterate over thread counts
-  for num in "${num_threads[@]}"; do
-    # Execute for stack types
-    for stack in "${stack_types[@]}"; do
-      echo "Running: ./container -i $input_file -o out.txt -t $num --stack=$stack"
-      perf stat -e cache-misses -e cache-references -e page-faults -e branch-instructions -e branch-misses ./container -i "$input_file" -o out.txt -t "$num" --stack="$stack"
-      
-      echo "Sorting out.txt"
-      wc -l out.txt
-      sed -i '/^0/d' out.txt
-      wc -l out.txt
-      sort -n out.txt -o out.txt
-      
-      
-     echo "Comparing out.txt with $input_file"
-     if diff out.txt "$input_file" > /dev/null; then
-        echo "Success: Output matches input"
-     else
-        echo "Failure: Output does not match input"
-     fi
-     echo "-----------------------------------------"
-     sleep 1
-    done
-
-    # Execute for queue types
-    for queue in "${queue_types[@]}"; do
-      echo "Running: ./container -i $input_file -o out.txt -t $num --queue=$queue"
-      perf stat -e cache-misses -e cache-references -e page-faults -e branch-instructions -e branch-misses ./container -i "$input_file" -o out.txt -t "$num" --queue="$queue"
-      
-      echo "Sorting out.txt"
-      wc -l out.txt
-      sed -i '/^0/d' out.txt
-      wc -l out.txt
-      sort -n out.txt -o out.txt
-     
-      echo "Comparing out.txt with $input_file"
-      if diff out.txt "$input_file" > /dev/null; then
-        echo "Success: Output matches input"
-      else
-        echo "Failure: Output does not match input"
-      fi
-      echo "-----------------------------------------"
-      sleep 1
-    done
-  done
-done
+#!/bin/bash
+
+make clean
+make            # make ALLOC=heap to compare against the global heap allocator
+
+./container -h
+
+# Arrays for parameter variations
+input_files=("1K_entry.txt")
+#"1_entry.txt" "100_entry.txt" "1K_entry.txt" "10K_entry.txt"
+
+num_threads=(4)
+#1 2 3 4 8 16
+
+stack_types=("sgl" "treiber" "treiber_tagged" "sgl_elim" "treiber_elim" "stack_flat" "dual" "multi" "chase_lev")
+#"sgl" "treiber" "treiber_tagged" "sgl_elim" "treiber_elim" "stack_flat" "dual" "multi" "chase_lev"
+
+queue_types=("sgl" "twolock" "mns" "mns_elim" "flat" "faa" "ring" "dual" "multi")
+#"sgl" "twolock" "mns" "mns_elim" "flat" "faa" "ring" "dual" "multi"
+
+# Iterate over input files
+for input_file in "${input_files[@]}"; do
+  # Iterate over thread counts
+  for num in "${num_threads[@]}"; do
+    # Execute for stack types
+    for stack in "${stack_types[@]}"; do
+      echo "Running: ./container -i $input_file -o out.txt -t $num --stack=$stack"
+      perf stat -e cache-misses -e cache-references -e page-faults -e branch-instructions -e branch-misses ./container -i "$input_file" -o out.txt -t "$num" --stack="$stack"
+      
+      echo "Sorting out.txt"
+      wc -l out.txt
+      sed -i '/^0/d' out.txt
+      wc -l out.txt
+      sort -n out.txt -o out.txt
+      
+      
+     echo "Comparing out.txt with $input_file"
+     if diff out.txt "$input_file" > /dev/null; then
+        echo "Success: Output matches input"
+     else
+        echo "Failure: Output does not match input"
+     fi
+     echo "-----------------------------------------"
+     sleep 1
+    done
+
+    # Execute for queue types
+    for queue in "${queue_types[@]}"; do
+      echo "Running: ./container -i $input_file -o out.txt -t $num --queue=$queue"
+      perf stat -e cache-misses -e cache-references -e page-faults -e branch-instructions -e branch-misses ./container -i "$input_file" -o out.txt -t "$num" --queue="$queue"
+      
+      echo "Sorting out.txt"
+      wc -l out.txt
+      sed -i '/^0/d' out.txt
+      wc -l out.txt
+      sort -n out.txt -o out.txt
+     
+      echo "Comparing out.txt with $input_file"
+      if diff out.txt "$input_file" > /dev/null; then
+        echo "Success: Output matches input"
+      else
+        echo "Failure: Output does not match input"
+      fi
+      echo "-----------------------------------------"
+      sleep 1
+    done
+  done
+done
+
+# Reclamation benchmark: replay the input to keep the lock-free containers under sustained load
+reclaim_policies=("leak" "hp" "ebr")
+bench_rounds=100
+
+for reclaim in "${reclaim_policies[@]}"; do
+  for num in "${num_threads[@]}"; do
+    for buffer in "--stack=treiber" "--stack=treiber_elim" "--stack=dual" "--queue=mns" "--queue=mns_elim" "--queue=faa" "--queue=dual"; do
+      echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --reclaim=$reclaim --bench=$bench_rounds"
+      ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --reclaim="$reclaim" --bench="$bench_rounds" | grep -E "Throughput|Peak RSS|Node allocations|Slab refills"
+      echo "-----------------------------------------"
+    done
+  done
+done
+
+# Lock, two-lock, CAS-retry M&S, flat combining and fetch-and-add queues as the thread count grows
+for num in 1 2 4 8 16 32 64; do
+  for queue in "sgl" "twolock" "mns" "flat" "faa"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num --queue=$queue --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" --queue="$queue" --bench="$bench_rounds" | grep -E "Throughput"
+  done
+  echo "-----------------------------------------"
+done
+
+# Single-producer/single-consumer channel: spsc (thread 0 pushes, thread 1 pops) against the MPMC queues on two
+# threads. The generic driver makes both MPMC threads push and pop, so they also run as a real producer/consumer pair
+# in workload mode (which rejects spsc).
+for queue in "spsc" "ring" "faa" "mns"; do
+  echo "Running: ./container -i 10K_entry.txt -o out.txt -t 2 --queue=$queue --bench=$bench_rounds"
+  ./container -i 10K_entry.txt -o out.txt -t 2 --queue="$queue" --bench="$bench_rounds" | grep -E "Throughput"
+done
+for queue in "ring" "faa" "mns"; do
+  echo "Running: ./container -t 2 --queue=$queue --ops=2000000 --producers=1 --consumers=1"
+  ./container -t 2 --queue="$queue" --ops=2000000 --producers=1 --consumers=1 | grep -E "Throughput"
+done
+
+# Bulk operations: amortize one CAS / lock hold over a batch of elements
+for batch in 1 8 64; do
+  for buffer in "--stack=sgl" "--stack=treiber" "--queue=mns" "--queue=faa" "--queue=ring"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t 4 $buffer --batch=$batch --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t 4 "$buffer" --batch="$batch" --bench="$bench_rounds" | grep -E "Throughput"
+  done
+  echo "-----------------------------------------"
+done
+# Bulk correctness: the Treiber stacks finish with drain() and faa pops with a clamped bulk claim; every element must come out once
+for buffer in "--stack=treiber" "--stack=treiber_elim" "--queue=faa"; do
+  for reclaim in "leak" "hp" "ebr"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t 4 $buffer --batch=8 --reclaim=$reclaim"
+    ./container -i 10K_entry.txt -o out.txt -t 4 "$buffer" --batch=8 --reclaim="$reclaim" > /dev/null
+    sed -i '/^0/d' out.txt
+    sort -n out.txt -o out.txt
+    if diff out.txt <(tr -d '\r' < 10K_entry.txt | sort -n) > /dev/null; then  # The input file has CRLF line endings
+      echo "Success: Output matches input"
+    else
+      echo "Failure: Output does not match input"
+    fi
+  done
+done
+echo "-----------------------------------------"
+
+# Adaptive elimination: hit rate of the elimination stacks and queue as the thread count grows
+for num in 2 4 8 16 32 64; do
+  for buffer in "--stack=treiber_elim" "--stack=sgl_elim" "--queue=mns" "--queue=mns_elim"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" | grep -E "Throughput|Elimination"
+  done
+  echo "-----------------------------------------"
+done
+
+# Layout policy: packed vs padded hot fields; the cache-miss counts show the false sharing removed by padding
+for layout in "packed" "padded"; do
+  make clean > /dev/null
+  make LAYOUT="$layout" > /dev/null
+  for buffer in "--stack=sgl_elim" "--stack=treiber_elim" "--stack=stack_flat" "--queue=mns" "--queue=mns_elim" "--queue=faa" "--queue=ring"; do
+    echo "Running ($layout): ./container -i 10K_entry.txt -o out.txt -t 8 $buffer --bench=$bench_rounds"
+    if command -v perf > /dev/null; then
+      perf stat -e cache-misses -e cache-references ./container -i 10K_entry.txt -o out.txt -t 8 "$buffer" --bench="$bench_rounds" 2>&1 | grep -E "Throughput|cache-misses|cache-references"
+    else
+      ./container -i 10K_entry.txt -o out.txt -t 8 "$buffer" --bench="$bench_rounds" | grep -E "Throughput"  # No perf: throughput only
+    fi
+  done
+  echo "-----------------------------------------"
+done
+
+# Lock policies of the lock-based containers as the thread count grows
+for num in 1 2 4 8 16; do
+  for lock in "tas" "ttas" "ticket" "mcs" "clh"; do
+    for buffer in "--stack=sgl" "--queue=sgl" "--queue=twolock"; do
+      echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --lock=$lock --bench=$bench_rounds"
+      ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --lock="$lock" --bench="$bench_rounds" | grep -E "Throughput"
+    done
+  done
+  echo "-----------------------------------------"
+done
+
+# Blocking pops: spinning pop vs pop_wait_for with a 100 us park timeout, oversubscribed
+for wait in 0 100; do
+  for buffer in "--stack=treiber" "--stack=sgl" "--stack=dual" "--queue=mns" "--queue=twolock" "--queue=ring" "--queue=dual"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t 16 $buffer --wait=$wait --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t 16 "$buffer" --wait="$wait" --bench="$bench_rounds" | grep -E "Throughput|Parking"
+  done
+  echo "-----------------------------------------"
+done
+
+# Relaxed sharded containers: throughput against their strict shard type, then how far the order drifts (--rank)
+for num in 1 2 4 8 16; do
+  for buffer in "--stack=treiber" "--stack=multi" "--queue=mns" "--queue=multi"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" | grep -E "Throughput"
+  done
+  for buffer in "--stack=multi" "--queue=multi"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --rank"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --rank | grep -E "Rank error"
+  done
+  echo "-----------------------------------------"
+done
+
+# Work stealing: per-thread Chase-Lev deques against the shared Treiber stack
+for num in 1 2 4 8 16; do
+  for buffer in "--stack=treiber" "--stack=chase_lev"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" | grep -E "Throughput|Work stealing"
+  done
+  echo "-----------------------------------------"
+done
+
+# Priority queue: every thread's delete_min results must come out non-decreasing, then throughput with --bench
+for num in 1 2 4 8 16; do
+  echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num --pq=skiplist"
+  ./container -i 10K_entry.txt -o out.txt -t "$num" --pq=skiplist | grep -E "Priority order"
+  sed -i '/^0/d' out.txt
+  sort -n out.txt -o out.txt
+  if diff out.txt <(tr -d '\r' < 10K_entry.txt | sort -n) > /dev/null; then  # The input file has CRLF line endings
+    echo "Success: Output matches input"
+  else
+    echo "Failure: Output does not match input"
+  fi
+  ./container -i 10K_entry.txt -o out.txt -t "$num" --pq=skiplist --bench="$bench_rounds" | grep -E "Throughput|Priority order"
+  # Overlapping phases: delete_min and its prefix cuts run against concurrent inserts; every key must come out once
+  for reclaim in "leak" "ebr"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num --pq=skiplist --overlap --reclaim=$reclaim --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" --pq=skiplist --overlap --reclaim="$reclaim" --bench="$bench_rounds" | grep -E "Throughput|Priority order|Conservation"
+  done
+  echo "-----------------------------------------"
+done
+
+# Synthetic workload: fixed-duration mixed runs, then a producer/consumer split and a zipf-keyed priority queue
+for num in 1 2 4 8 16; do
+  for buffer in "--stack=treiber" "--stack=sgl" "--queue=mns" "--queue=faa"; do
+    echo "Running: ./container -t $num $buffer --duration=200 --mix=50 --prefill=1000"
+    ./container -t "$num" "$buffer" --duration=200 --mix=50 --prefill=1000 | grep -E "Throughput"
+  done
+  echo "-----------------------------------------"
+done
+echo "Running: ./container -t 4 --queue=mns --ops=4000000 --producers=2 --consumers=2"
+./container -t 4 --queue=mns --ops=4000000 --producers=2 --consumers=2 | grep -E "Thread|Throughput"
+echo "Running: ./container -t 4 --pq=skiplist --duration=200 --keys=zipf --prefill=10000"
+./container -t 4 --pq=skiplist --duration=200 --keys=zipf --prefill=10000 | grep -E "Thread|Throughput"
+
+# Latency: push/pop percentiles of the elimination and flat-combining stacks against the plain ones
+for num in 1 4 16; do
+  for buffer in "--stack=sgl" "--stack=treiber" "--stack=sgl_elim" "--stack=treiber_elim" "--stack=stack_flat" "--queue=mns"; do
+    echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds --latency"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" --latency | grep -E "Latency"
+  done
+  echo "-----------------------------------------"
+done
+
+# Thread placement: unpinned against compact (shared caches) and scatter (separate cores and packages)
+for num in 2 4 8; do
+  for buffer in "--stack=treiber" "--stack=treiber_elim" "--queue=mns" "--queue=faa"; do
+    for affinity in "" "--affinity=compact" "--affinity=scatter"; do
+      echo "Running: ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds $affinity"
+      ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" $affinity | grep -E "Affinity|Throughput"
+    done
+  done
+  echo "-----------------------------------------"
+done
+
+# Input loader: parse a 10M-line file, convert it to the binary format and load that (files in a temporary directory)
+loader_dir=$(mktemp -d)
+seq 1 10000000 | shuf > "$loader_dir/10M_entry.txt"
+echo "Running: ./container -i $loader_dir/10M_entry.txt -o out.txt -t 4 --stack=treiber --save-binary=$loader_dir/10M_entry.bin"
+./container -i "$loader_dir/10M_entry.txt" -o out.txt -t 4 --stack=treiber --save-binary="$loader_dir/10M_entry.bin" | grep -E "Input|Wrote"
+echo "Running: ./container -i $loader_dir/10M_entry.bin -o out.txt -t 4 --stack=treiber"
+./container -i "$loader_dir/10M_entry.bin" -o out.txt -t 4 --stack=treiber | grep -E "Input|Elapsed"
+rm -rf "$loader_dir"
+echo "-----------------------------------------"
+
+# Contention counters: why treiber_elim and treiber diverge as threads are added (counters compiled in, then out again)
+make clean > /dev/null
+make STATS=on > /dev/null
+for num in 4 16; do
+  for buffer in "--stack=treiber" "--stack=treiber_elim" "--stack=sgl_elim" "--stack=stack_flat" "--queue=mns_elim"; do
+    echo "Running (STATS=on): ./container -i 10K_entry.txt -o out.txt -t $num $buffer --bench=$bench_rounds"
+    ./container -i 10K_entry.txt -o out.txt -t "$num" "$buffer" --bench="$bench_rounds" | grep -E "Throughput|Contention"
+  done
+  echo "-----------------------------------------"
+done
+make clean > /dev/null
+make > /dev/null